@@ -0,0 +1,86 @@
+#include <StaticAnalysis/ScenarioGraph.hpp>
+#include <StaticAnalysis/ScenarioMetrics.hpp>
+
+#include <chrono>
+#include <cstdio>
+
+// Times the cyclomatic block computation on synthetic wide, trigger-heavy
+// scores.
+namespace
+{
+using stal::ScenarioGraph;
+using index = ScenarioGraph::index;
+
+// Synthetic score made of `depth` layers of `width` parallel intervals.
+// Each layer ends on a single time sync, which has a trigger every other
+// layer, and one event out of eight has a condition.
+ScenarioGraph benchmarkGraph(index width, index depth)
+{
+  ScenarioGraph g;
+  for (index ts = 0; ts <= depth; ts++)
+  {
+    g.timeSyncActive.push_back(ts % 2);
+    g.timeSyncHasExpression.push_back(ts % 2);
+    for (index lane = 0; lane < width; lane++)
+    {
+      g.eventTimeSync.push_back(ts);
+      g.eventHasCondition.push_back(lane % 8 == 7);
+    }
+  }
+
+  for (index ts = 0; ts < depth; ts++)
+  {
+    for (index lane = 0; lane < width; lane++)
+    {
+      const index itv = g.intervalStartState.size();
+      const index st = g.stateEvent.size();
+      g.stateEvent.push_back(ts * width + lane);
+      g.statePreviousInterval.push_back(ScenarioGraph::none);
+      g.stateNextInterval.push_back(itv);
+      g.stateEvent.push_back((ts + 1) * width + lane);
+      g.statePreviousInterval.push_back(itv);
+      g.stateNextInterval.push_back(ScenarioGraph::none);
+
+      g.intervalStartState.push_back(st);
+      g.intervalEndState.push_back(st + 1);
+      g.intervalRigid.push_back(true);
+    }
+  }
+
+  // No model behind : only the sizes of the pointer tables matter.
+  g.intervals.resize(g.intervalStartState.size());
+  g.events.resize(g.eventTimeSync.size());
+  g.timeSyncs.resize(g.timeSyncActive.size());
+  g.states.resize(g.stateEvent.size());
+  g.scenarioStart = 0;
+  g.link();
+  return g;
+}
+}
+
+int main()
+{
+  constexpr ScenarioGraph::index depth = 64;
+  std::printf("width\tdepth\telements\tblocks\ttime (ms)\tns / element\n");
+  for (ScenarioGraph::index width : {16, 64, 256, 1024, 4096})
+  {
+    const auto scenar = benchmarkGraph(width, depth);
+    const auto elements = scenar.intervals.size() + scenar.events.size()
+                          + scenar.timeSyncs.size();
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const auto block_count
+        = stal::Metrics::Cyclomatic::ComputeBlocks(scenar).blockCount();
+    const auto t1 = std::chrono::steady_clock::now();
+
+    const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    std::printf(
+        "%u\t%u\t%zu\t%zu\t%g\t%g\n",
+        width,
+        depth,
+        elements,
+        block_count,
+        ns / 1e6,
+        ns / double(elements));
+  }
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <score/command/AggregateCommand.hpp>
+#include <score/command/Command.hpp>
+
+namespace stal
+{
+inline const CommandGroupKey& CommandFactoryName()
+{
+  static const CommandGroupKey key{"StaticAnalysis"};
+  return key;
+}
+
+//! Groups the label changes made from an analysis result in one undo step.
+class LabelBlocks final : public score::AggregateCommand
+{
+  SCORE_COMMAND_DECL(
+      stal::CommandFactoryName(),
+      LabelBlocks,
+      "Label cyclomatic blocks")
+};
+}
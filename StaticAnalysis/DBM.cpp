@@ -0,0 +1,163 @@
+#include "DBM.hpp"
+
+#include <algorithm>
+
+namespace stal
+{
+DBM::DBM(int clocks)
+    : m_dim{clocks + 1}, m_bounds(m_dim * m_dim, bounds::le(0))
+{
+}
+
+bool DBM::constrain(int i, int j, Bound b)
+{
+  using namespace bounds;
+  if (empty())
+    return false;
+  if (b >= at(i, j))
+    return true;
+  if (add(at(j, i), b) < le(0))
+  {
+    at(0, 0) = lt(0);
+    return false;
+  }
+
+  at(i, j) = b;
+
+  // Only the paths through the new constraint can get shorter.
+  for (int pivot : {i, j})
+  {
+    for (int k = 0; k < m_dim; k++)
+    {
+      const Bound to_pivot = at(k, pivot);
+      if (to_pivot == infinity)
+        continue;
+      for (int l = 0; l < m_dim; l++)
+      {
+        const Bound via = add(to_pivot, at(pivot, l));
+        if (via < at(k, l))
+          at(k, l) = via;
+      }
+    }
+  }
+  return true;
+}
+
+void DBM::up() noexcept
+{
+  for (int i = 1; i < m_dim; i++)
+    at(i, 0) = bounds::infinity;
+}
+
+void DBM::down() noexcept
+{
+  for (int i = 1; i < m_dim; i++)
+  {
+    at(0, i) = bounds::le(0);
+    for (int j = 1; j < m_dim; j++)
+      at(0, i) = std::min(at(0, i), at(j, i));
+  }
+}
+
+DBM DBM::remap(const std::vector<int>& from) const
+{
+  DBM res{int(from.size())};
+  auto old = [&](int i) { return i == 0 || from[i - 1] < 0 ? 0 : from[i - 1]; };
+  for (int i = 0; i < res.m_dim; i++)
+    for (int j = 0; j < res.m_dim; j++)
+      res.at(i, j) = (*this)(old(i), old(j));
+  return res;
+}
+
+void DBM::extrapolate(const std::vector<int32_t>& maxConstants)
+{
+  using namespace bounds;
+  bool changed = false;
+  for (int i = 0; i < m_dim; i++)
+  {
+    for (int j = 0; j < m_dim; j++)
+    {
+      Bound& b = at(i, j);
+      if (i == j || b == infinity)
+        continue;
+
+      if (i != 0 && b > le(maxConstants[i - 1]))
+      {
+        b = infinity;
+        changed = true;
+      }
+      else if (j != 0 && b < lt(-maxConstants[j - 1]))
+      {
+        b = lt(-maxConstants[j - 1]);
+        changed = true;
+      }
+    }
+  }
+
+  if (changed)
+    close();
+}
+
+bool DBM::includedIn(const DBM& other) const noexcept
+{
+  if (empty())
+    return true;
+  for (std::size_t i = 0; i < m_bounds.size(); i++)
+    if (m_bounds[i] > other.m_bounds[i])
+      return false;
+  return true;
+}
+
+std::vector<DBM> DBM::subtract(const DBM& other) const
+{
+  std::vector<DBM> res;
+  if (empty())
+    return res;
+  if (other.empty())
+  {
+    res.push_back(*this);
+    return res;
+  }
+
+  // Each piece violates one constraint of the other zone and satisfies
+  // the ones before it, so that the pieces are disjoint.
+  DBM rest = *this;
+  for (int i = 0; i < m_dim; i++)
+  {
+    for (int j = 0; j < m_dim; j++)
+    {
+      const Bound b = other(i, j);
+      if (i == j || b == bounds::infinity || b >= rest(i, j))
+        continue;
+
+      DBM piece = rest;
+      if (piece.constrain(j, i, bounds::negate(b)))
+        res.push_back(std::move(piece));
+      if (!rest.constrain(i, j, b))
+        return res;
+    }
+  }
+  return res;
+}
+
+void DBM::close()
+{
+  using namespace bounds;
+  for (int k = 0; k < m_dim; k++)
+    for (int i = 0; i < m_dim; i++)
+    {
+      const Bound to_k = at(i, k);
+      if (to_k == infinity)
+        continue;
+      for (int j = 0; j < m_dim; j++)
+        at(i, j) = std::min(at(i, j), add(to_k, at(k, j)));
+    }
+
+  for (int i = 0; i < m_dim; i++)
+    if (at(i, i) < le(0))
+    {
+      at(0, 0) = lt(0);
+      return;
+    }
+}
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace stal
+{
+/**
+ * @brief Bound of a difference constraint xi - xj < c or xi - xj <= c.
+ *
+ * Encoded as 2c + 1 when non-strict and 2c when strict, so that bounds
+ * compare as integers : a smaller bound is a tighter constraint.
+ */
+using Bound = int32_t;
+
+namespace bounds
+{
+constexpr Bound infinity = std::numeric_limits<Bound>::max();
+
+constexpr Bound le(int32_t c) noexcept { return c * 2 + 1; }
+constexpr Bound lt(int32_t c) noexcept { return c * 2; }
+constexpr int32_t value(Bound b) noexcept { return b >> 1; }
+constexpr bool strict(Bound b) noexcept { return (b & 1) == 0; }
+
+constexpr Bound add(Bound a, Bound b) noexcept
+{
+  if (a == infinity || b == infinity)
+    return infinity;
+  return (value(a) + value(b)) * 2 + (a & b & 1);
+}
+
+//! xi - xj > c is xj - xi < -c.
+constexpr Bound negate(Bound b) noexcept
+{
+  return strict(b) ? le(-value(b)) : lt(-value(b));
+}
+}
+
+/**
+ * @brief Difference bound matrix : a zone over clocks x1 .. xn.
+ *
+ * Entry (i, j) bounds xi - xj, x0 being the constant zero. The matrix is
+ * always kept canonical, i.e. each bound is the tightest implied by the
+ * others, so that inclusion and emptiness are direct comparisons.
+ */
+class DBM
+{
+public:
+  //! Zone where all the clocks are zero.
+  explicit DBM(int clocks);
+
+  int clocks() const noexcept { return m_dim - 1; }
+  Bound operator()(int i, int j) const noexcept { return m_bounds[i * m_dim + j]; }
+
+  bool empty() const noexcept { return (*this)(0, 0) < bounds::le(0); }
+
+  //! Adds xi - xj <= b. Returns false if the zone becomes empty.
+  bool constrain(int i, int j, Bound b);
+
+  //! Lets time elapse.
+  void up() noexcept;
+
+  //! Every valuation from which the zone can be reached by letting time elapse.
+  void down() noexcept;
+
+  /**
+   * @brief Zone over another set of clocks.
+   *
+   * Clock i of the result is clock from[i - 1] of this zone, or a clock set
+   * to zero if it is negative : clocks which do not appear are forgotten.
+   */
+  DBM remap(const std::vector<int>& from) const;
+
+  //! Widens the bounds beyond the largest constant each clock is compared to.
+  void extrapolate(const std::vector<int32_t>& maxConstants);
+
+  bool includedIn(const DBM& other) const noexcept;
+
+  //! Disjoint zones whose union is this zone minus the other one.
+  std::vector<DBM> subtract(const DBM& other) const;
+
+  bool operator==(const DBM& other) const noexcept
+  {
+    return m_bounds == other.m_bounds;
+  }
+
+private:
+  Bound& at(int i, int j) noexcept { return m_bounds[i * m_dim + j]; }
+  void close();
+
+  int m_dim{};
+  std::vector<Bound> m_bounds;
+};
+}
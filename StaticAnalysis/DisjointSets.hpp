@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace stal
+{
+/**
+ * @brief Union-find over dense indices.
+ *
+ * Union by size with path halving : both operations are iterative and run
+ * in quasi-constant amortized time, whatever the shape of the graph.
+ */
+class DisjointSets
+{
+public:
+  using index = uint32_t;
+
+  explicit DisjointSets(std::size_t n) : m_parent(n), m_size(n, 1)
+  {
+    std::iota(m_parent.begin(), m_parent.end(), index{0});
+  }
+
+  index find(index x) noexcept
+  {
+    while (m_parent[x] != x)
+    {
+      m_parent[x] = m_parent[m_parent[x]];
+      x = m_parent[x];
+    }
+    return x;
+  }
+
+  //! Returns false if both elements were already in the same set.
+  bool unite(index a, index b) noexcept
+  {
+    a = find(a);
+    b = find(b);
+    if (a == b)
+      return false;
+
+    if (m_size[a] < m_size[b])
+      std::swap(a, b);
+    m_parent[b] = a;
+    m_size[a] += m_size[b];
+    return true;
+  }
+
+  std::size_t size() const noexcept { return m_parent.size(); }
+
+private:
+  std::vector<index> m_parent;
+  std::vector<index> m_size;
+};
+}
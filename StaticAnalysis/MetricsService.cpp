@@ -0,0 +1,245 @@
+#include "MetricsService.hpp"
+
+#include "ScenarioGraph.hpp"
+#include "ThreadPool.hpp"
+
+#include <Scenario/Document/Event/EventModel.hpp>
+#include <Scenario/Document/Interval/IntervalDurations.hpp>
+#include <Scenario/Document/Interval/IntervalModel.hpp>
+#include <Scenario/Document/State/StateModel.hpp>
+#include <Scenario/Document/TimeSync/TimeSyncModel.hpp>
+#include <Scenario/Process/ScenarioModel.hpp>
+
+namespace stal
+{
+MetricsService::MetricsService(const Scenario::ProcessModel& root)
+    : m_root{root}
+{
+  watch(root);
+}
+
+MetricsService::~MetricsService() = default;
+
+Metrics::Halstead::Factors MetricsService::halstead()
+{
+  update();
+
+  Metrics::Halstead::Counts counts;
+  for (const auto& [scenar, scope] : m_scopes)
+    counts += scope.counts;
+  return Metrics::Halstead::ComputeFactors(counts);
+}
+
+Metrics::Cyclomatic::Factors MetricsService::cyclomatic()
+{
+  if (!m_cyclomatic)
+    m_cyclomatic
+        = Metrics::Cyclomatic::ComputeFactors(ScenarioGraph{m_root, false});
+  return *m_cyclomatic;
+}
+
+Metrics::Cyclomatic::Factors MetricsService::cyclomatic2()
+{
+  if (!m_cyclomatic2)
+    m_cyclomatic2
+        = Metrics::Cyclomatic::ComputeFactors2(ScenarioGraph{m_root, false});
+  return *m_cyclomatic2;
+}
+
+void MetricsService::update()
+{
+  // Each scenario is counted on its own : its sub-scenarios have their
+  // own scope, so the graph does not need to go through them.
+  TaskGroup tasks;
+  for (auto& [scenar, scope] : m_scopes)
+  {
+    if (scope.dirty)
+    {
+      tasks.run([scenar = scenar, &scope = scope] {
+        scope.counts
+            = Metrics::Halstead::ComputeCounts(ScenarioGraph{*scenar, false});
+        scope.dirty = false;
+      });
+    }
+  }
+  tasks.wait();
+}
+
+void MetricsService::markDirty(const Scenario::ProcessModel& scenar)
+{
+  if (auto it = m_scopes.find(&scenar); it != m_scopes.end())
+    it->second.dirty = true;
+
+  if (&scenar == &m_root)
+  {
+    m_cyclomatic.reset();
+    m_cyclomatic2.reset();
+  }
+}
+
+// The elements of a scenario are children of its model.
+void MetricsService::markParentDirty(const QObject& element)
+{
+  if (auto scenar
+      = dynamic_cast<const Scenario::ProcessModel*>(element.parent()))
+    markDirty(*scenar);
+}
+
+void MetricsService::watch(const Scenario::ProcessModel& scenar)
+{
+  m_scopes[&scenar].dirty = true;
+
+  scenar.intervals.added.connect<&MetricsService::on_intervalAdded>(this);
+  scenar.intervals.removing.connect<&MetricsService::on_intervalRemoving>(
+      this);
+  scenar.events.added.connect<&MetricsService::on_eventAdded>(this);
+  scenar.events.removing.connect<&MetricsService::on_eventRemoving>(this);
+  scenar.timeSyncs.added.connect<&MetricsService::on_timeSyncAdded>(this);
+  scenar.timeSyncs.removing.connect<&MetricsService::on_timeSyncRemoving>(
+      this);
+  scenar.states.added.connect<&MetricsService::on_stateChanged>(this);
+  scenar.states.removing.connect<&MetricsService::on_stateChanged>(this);
+
+  for (const auto& itv : scenar.intervals)
+    watchInterval(itv);
+  for (const auto& ev : scenar.events)
+    watchEvent(ev);
+  for (const auto& ts : scenar.timeSyncs)
+    watchTimeSync(ts);
+}
+
+void MetricsService::unwatch(const Scenario::ProcessModel& scenar)
+{
+  scenar.intervals.added.disconnect<&MetricsService::on_intervalAdded>(this);
+  scenar.intervals.removing
+      .disconnect<&MetricsService::on_intervalRemoving>(this);
+  scenar.events.added.disconnect<&MetricsService::on_eventAdded>(this);
+  scenar.events.removing.disconnect<&MetricsService::on_eventRemoving>(this);
+  scenar.timeSyncs.added.disconnect<&MetricsService::on_timeSyncAdded>(this);
+  scenar.timeSyncs.removing
+      .disconnect<&MetricsService::on_timeSyncRemoving>(this);
+  scenar.states.added.disconnect<&MetricsService::on_stateChanged>(this);
+  scenar.states.removing.disconnect<&MetricsService::on_stateChanged>(this);
+
+  for (const auto& itv : scenar.intervals)
+    unwatchInterval(itv);
+  for (const auto& ev : scenar.events)
+    QObject::disconnect(&ev, nullptr, this, nullptr);
+  for (const auto& ts : scenar.timeSyncs)
+    QObject::disconnect(&ts, nullptr, this, nullptr);
+
+  m_scopes.erase(&scenar);
+}
+
+void MetricsService::watchInterval(const Scenario::IntervalModel& itv)
+{
+  itv.processes.added.connect<&MetricsService::on_processAdded>(this);
+  itv.processes.removing.connect<&MetricsService::on_processRemoving>(this);
+
+  // The kind of duration is counted by the Halstead metrics.
+  auto dirty = [this, &itv] { markParentDirty(itv); };
+  const auto& duration = itv.duration;
+  connect(
+      &duration, &Scenario::IntervalDurations::minDurationChanged, this, dirty);
+  connect(
+      &duration, &Scenario::IntervalDurations::maxDurationChanged, this, dirty);
+  connect(
+      &duration, &Scenario::IntervalDurations::rigidityChanged, this, dirty);
+
+  for (const auto& proc : itv.processes)
+  {
+    if (auto sub = dynamic_cast<const Scenario::ProcessModel*>(&proc))
+      watch(*sub);
+  }
+}
+
+void MetricsService::unwatchInterval(const Scenario::IntervalModel& itv)
+{
+  itv.processes.added.disconnect<&MetricsService::on_processAdded>(this);
+  itv.processes.removing.disconnect<&MetricsService::on_processRemoving>(
+      this);
+  QObject::disconnect(&itv.duration, nullptr, this, nullptr);
+
+  for (const auto& proc : itv.processes)
+  {
+    if (auto sub = dynamic_cast<const Scenario::ProcessModel*>(&proc))
+      unwatch(*sub);
+  }
+}
+
+void MetricsService::watchEvent(const Scenario::EventModel& ev)
+{
+  connect(&ev, &Scenario::EventModel::conditionChanged, this, [this, &ev] {
+    markParentDirty(ev);
+  });
+}
+
+void MetricsService::watchTimeSync(const Scenario::TimeSyncModel& ts)
+{
+  auto dirty = [this, &ts] { markParentDirty(ts); };
+  connect(&ts, &Scenario::TimeSyncModel::activeChanged, this, dirty);
+  connect(&ts, &Scenario::TimeSyncModel::triggerChanged, this, dirty);
+  connect(&ts, &Scenario::TimeSyncModel::newEvent, this, dirty);
+  connect(&ts, &Scenario::TimeSyncModel::eventRemoved, this, dirty);
+}
+
+void MetricsService::on_intervalAdded(const Scenario::IntervalModel& itv)
+{
+  markParentDirty(itv);
+  watchInterval(itv);
+}
+
+void MetricsService::on_intervalRemoving(const Scenario::IntervalModel& itv)
+{
+  markParentDirty(itv);
+  unwatchInterval(itv);
+}
+
+void MetricsService::on_eventAdded(const Scenario::EventModel& ev)
+{
+  markParentDirty(ev);
+  watchEvent(ev);
+}
+
+void MetricsService::on_eventRemoving(const Scenario::EventModel& ev)
+{
+  markParentDirty(ev);
+  QObject::disconnect(&ev, nullptr, this, nullptr);
+}
+
+void MetricsService::on_timeSyncAdded(const Scenario::TimeSyncModel& ts)
+{
+  markParentDirty(ts);
+  watchTimeSync(ts);
+}
+
+void MetricsService::on_timeSyncRemoving(const Scenario::TimeSyncModel& ts)
+{
+  markParentDirty(ts);
+  QObject::disconnect(&ts, nullptr, this, nullptr);
+}
+
+void MetricsService::on_stateChanged(const Scenario::StateModel& st)
+{
+  markParentDirty(st);
+}
+
+// Processes are children of their interval.
+void MetricsService::on_processAdded(const Process::ProcessModel& proc)
+{
+  if (auto itv = proc.parent())
+    markParentDirty(*itv);
+
+  if (auto sub = dynamic_cast<const Scenario::ProcessModel*>(&proc))
+    watch(*sub);
+}
+
+void MetricsService::on_processRemoving(const Process::ProcessModel& proc)
+{
+  if (auto itv = proc.parent())
+    markParentDirty(*itv);
+
+  if (auto sub = dynamic_cast<const Scenario::ProcessModel*>(&proc))
+    unwatch(*sub);
+}
+}
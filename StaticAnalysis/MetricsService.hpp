@@ -0,0 +1,80 @@
+#pragma once
+#include <StaticAnalysis/ScenarioMetrics.hpp>
+
+#include <QObject>
+
+#include <nano_observer.hpp>
+
+#include <optional>
+#include <unordered_map>
+
+namespace Process
+{
+class ProcessModel;
+}
+namespace Scenario
+{
+class IntervalModel;
+class EventModel;
+class TimeSyncModel;
+class StateModel;
+}
+
+namespace stal
+{
+/**
+ * @brief Keeps the metrics of a score up to date while it is edited.
+ *
+ * The Halstead counts of every scenario of the hierarchy are cached.
+ * Adding or removing an element of a scenario, or changing a condition or
+ * a trigger, only marks this scenario dirty : the next query recomputes
+ * the dirty scenarios and reuses the cached counts of all the others.
+ */
+class MetricsService final
+    : public QObject
+    , public Nano::Observer
+{
+public:
+  explicit MetricsService(const Scenario::ProcessModel& root);
+  ~MetricsService();
+
+  Metrics::Halstead::Factors halstead();
+  Metrics::Cyclomatic::Factors cyclomatic();
+  Metrics::Cyclomatic::Factors cyclomatic2();
+
+private:
+  struct Scope
+  {
+    bool dirty{true};
+    Metrics::Halstead::Counts counts;
+  };
+
+  void update();
+  void markDirty(const Scenario::ProcessModel& scenar);
+  void markParentDirty(const QObject& element);
+
+  void watch(const Scenario::ProcessModel& scenar);
+  void unwatch(const Scenario::ProcessModel& scenar);
+  void watchInterval(const Scenario::IntervalModel& itv);
+  void unwatchInterval(const Scenario::IntervalModel& itv);
+  void watchEvent(const Scenario::EventModel& ev);
+  void watchTimeSync(const Scenario::TimeSyncModel& ts);
+
+  void on_intervalAdded(const Scenario::IntervalModel& itv);
+  void on_intervalRemoving(const Scenario::IntervalModel& itv);
+  void on_eventAdded(const Scenario::EventModel& ev);
+  void on_eventRemoving(const Scenario::EventModel& ev);
+  void on_timeSyncAdded(const Scenario::TimeSyncModel& ts);
+  void on_timeSyncRemoving(const Scenario::TimeSyncModel& ts);
+  void on_stateChanged(const Scenario::StateModel& st);
+  void on_processAdded(const Process::ProcessModel& proc);
+  void on_processRemoving(const Process::ProcessModel& proc);
+
+  const Scenario::ProcessModel& m_root;
+  std::unordered_map<const Scenario::ProcessModel*, Scope> m_scopes;
+
+  // Only depend on the top-level scenario
+  std::optional<Metrics::Cyclomatic::Factors> m_cyclomatic;
+  std::optional<Metrics::Cyclomatic::Factors> m_cyclomatic2;
+};
+}
@@ -39,6 +39,7 @@ struct ISVisitor
 {
   std::string ss;
   int depth = 0;
+  NameCache names;
 
   void append(std::string l)
   {
@@ -106,7 +107,7 @@ void ISVisitor::visit(
   // First we create a point for the timenode. The ingoing
   // intervals will end on this point.
 
-  QString tn_name = name(timenode);
+  const std::string& tn_name = names(timenode);
   ;
 
   if(timenode.active())
@@ -135,8 +136,8 @@ void ISVisitor::visit(
 {
   using namespace Scenario;
   const auto& timenode = parentTimeSync(event, scenario);
-  QString tn_name = name(timenode);
-  QString event_name = name(event);
+  const std::string& tn_name = names(timenode);
+  const std::string& event_name = names(event);
 }
 
 void ISVisitor::visit(
@@ -173,8 +174,8 @@ void ISVisitor::visit(const Scenario::ScenarioInterface& s)
 
 void ISVisitor::visit(const Automation::ProcessModel& s)
 {
-  auto scenar = object("texture", name(s).toStdString());
-  prop("name", "\"" + name(s).toStdString() + "\"");
+  auto scenar = object("texture", names(s));
+  prop("name", "\"" + names(s) + "\"");
 }
 
 void ISVisitor::visit(
@@ -183,16 +184,17 @@ void ISVisitor::visit(
   using namespace Scenario;
   auto& stn = startTimeSync(c, scenario);
   auto& sev = startEvent(c, scenario);
-  QString parent_name = name(dynamic_cast<const QObject&>(scenario));
-  QString start_event_name = name(startEvent(c, scenario));
+  const std::string& parent_name
+      = names(dynamic_cast<const QObject&>(scenario));
+  const std::string& start_event_name = names(startEvent(c, scenario));
 
   const TimeSyncModel& end_node = endTimeSync(c, scenario);
-  QString end_node_name = name(end_node);
+  const std::string& end_node_name = names(end_node);
 
-  QString cst_name = name(c);
+  const std::string& cst_name = names(c);
 
-  auto scenar = object("structure", name(c).toStdString());
-  prop("name", "\"" + name(c).toStdString() + "\"");
+  auto scenar = object("structure", names(c));
+  prop("name", "\"" + names(c) + "\"");
 
   // Condition: all previous intervals finished
   if(auto* sc = dynamic_cast<const Scenario::ProcessModel*>(&scenario))
@@ -209,7 +211,7 @@ void ISVisitor::visit(
       {
         auto& itv = scenario.interval(id);
         condition += fmt::format(
-            "wait(start({}), {}, {}) /\\", name(itv).toStdString(),
+            "wait(start({}), {}, {}) /\\", names(itv),
             (int)itv.duration.minDuration().msec(),
             (int)itv.duration.maxDuration().msec());
       }
@@ -0,0 +1,180 @@
+#include "ScenarioGraph.hpp"
+
+#include <Scenario/Document/Event/EventModel.hpp>
+#include <Scenario/Document/Interval/IntervalModel.hpp>
+#include <Scenario/Document/State/StateModel.hpp>
+#include <Scenario/Document/TimeSync/TimeSyncModel.hpp>
+#include <Scenario/Process/ScenarioModel.hpp>
+
+#include <unordered_map>
+
+namespace stal
+{
+namespace
+{
+using index = ScenarioGraph::index;
+using Adjacency = ScenarioGraph::Adjacency;
+
+// Builds a -> c from a -> b and b -> c, keeping the order of both relations.
+template <typename F>
+Adjacency compose(const Adjacency& ab, F&& bc)
+{
+  Adjacency ac;
+  const auto n = ab.size();
+  ac.offsets.reserve(n + 1);
+  for (index a = 0; a < n; a++)
+  {
+    for (index b : ab[a])
+    {
+      const index c = bc(b);
+      if (c != ScenarioGraph::none)
+        ac.values.push_back(c);
+    }
+    ac.offsets.push_back(ac.values.size());
+  }
+  return ac;
+}
+
+Adjacency compose_all(const Adjacency& ab, const Adjacency& bc)
+{
+  Adjacency ac;
+  const auto n = ab.size();
+  ac.offsets.reserve(n + 1);
+  for (index a = 0; a < n; a++)
+  {
+    for (index b : ab[a])
+      for (index c : bc[b])
+        ac.values.push_back(c);
+    ac.offsets.push_back(ac.values.size());
+  }
+  return ac;
+}
+
+// Builds the inverse of a many-to-one relation, with a counting sort.
+Adjacency invert(const std::vector<index>& parent, std::size_t parent_count)
+{
+  Adjacency res;
+  res.offsets.assign(parent_count + 1, 0);
+  for (index p : parent)
+    res.offsets[p + 1]++;
+  for (std::size_t i = 0; i < parent_count; i++)
+    res.offsets[i + 1] += res.offsets[i];
+
+  res.values.resize(parent.size());
+  std::vector<index> pos(res.offsets.begin(), res.offsets.end() - 1);
+  for (index c = 0; c < parent.size(); c++)
+    res.values[pos[parent[c]]++] = c;
+  return res;
+}
+
+template <typename Container, typename T>
+auto make_index(const Container& c, std::vector<const T*>& vec)
+{
+  std::unordered_map<int32_t, index> ids;
+  ids.reserve(c.size());
+  vec.reserve(c.size());
+  for (const T& elt : c)
+  {
+    ids.emplace(elt.id_val(), vec.size());
+    vec.push_back(&elt);
+  }
+  return ids;
+}
+}
+
+ScenarioGraph::ScenarioGraph(
+    const Scenario::ProcessModel& scenar,
+    bool recursive)
+    : model{&scenar}
+{
+  const auto itv_idx = make_index(scenar.intervals, intervals);
+  const auto ev_idx = make_index(scenar.events, events);
+  const auto ts_idx = make_index(scenar.timeSyncs, timeSyncs);
+  const auto st_idx = make_index(scenar.states, states);
+
+  intervalStartState.reserve(intervals.size());
+  intervalEndState.reserve(intervals.size());
+  intervalRigid.reserve(intervals.size());
+  intervalSubScenarios.offsets.reserve(intervals.size() + 1);
+  for (const Scenario::IntervalModel* itv : intervals)
+  {
+    intervalStartState.push_back(st_idx.at(itv->startState().val()));
+    intervalEndState.push_back(st_idx.at(itv->endState().val()));
+    intervalRigid.push_back(itv->duration.isRigid());
+
+    for (const auto& process : itv->processes)
+    {
+      if (auto sub = dynamic_cast<const Scenario::ProcessModel*>(&process))
+      {
+        intervalSubScenarios.values.push_back(subScenarios.size());
+        subScenarios.push_back(SubScenario{
+            sub,
+            sub->id_val(),
+            recursive ? std::make_unique<ScenarioGraph>(*sub) : nullptr});
+      }
+    }
+    intervalSubScenarios.offsets.push_back(subScenarios.size());
+  }
+
+  statePreviousInterval.reserve(states.size());
+  stateNextInterval.reserve(states.size());
+  stateEvent.reserve(states.size());
+  for (const Scenario::StateModel* st : states)
+  {
+    const auto& prev = st->previousInterval();
+    const auto& next = st->nextInterval();
+    statePreviousInterval.push_back(prev ? itv_idx.at(prev->val()) : none);
+    stateNextInterval.push_back(next ? itv_idx.at(next->val()) : none);
+    stateEvent.push_back(ev_idx.at(st->eventId().val()));
+  }
+
+  eventTimeSync.reserve(events.size());
+  eventHasCondition.reserve(events.size());
+  eventStates.offsets.reserve(events.size() + 1);
+  for (const Scenario::EventModel* ev : events)
+  {
+    eventTimeSync.push_back(ts_idx.at(ev->timeSync().val()));
+    eventHasCondition.push_back(ev->condition().hasChildren());
+    for (const auto& st : ev->states())
+      eventStates.values.push_back(st_idx.at(st.val()));
+    eventStates.offsets.push_back(eventStates.values.size());
+  }
+
+  timeSyncActive.reserve(timeSyncs.size());
+  timeSyncHasExpression.reserve(timeSyncs.size());
+  timeSyncEvents.offsets.reserve(timeSyncs.size() + 1);
+  for (const Scenario::TimeSyncModel* ts : timeSyncs)
+  {
+    timeSyncActive.push_back(ts->active());
+    timeSyncHasExpression.push_back(ts->expression().hasChildren());
+    for (const auto& ev : ts->events())
+      timeSyncEvents.values.push_back(ev_idx.at(ev.val()));
+    timeSyncEvents.offsets.push_back(timeSyncEvents.values.size());
+  }
+
+  scenarioStart = ts_idx.at(scenar.startTimeSync().id_val());
+
+  link();
+}
+
+ScenarioGraph::~ScenarioGraph() = default;
+
+void ScenarioGraph::link()
+{
+  // Synthetic graphs may only give the parent of each element.
+  if (eventStates.size() != eventTimeSync.size())
+    eventStates = invert(stateEvent, eventTimeSync.size());
+  if (timeSyncEvents.size() != timeSyncActive.size())
+    timeSyncEvents = invert(eventTimeSync, timeSyncActive.size());
+  if (intervalSubScenarios.size() != intervalStartState.size())
+    intervalSubScenarios.offsets.assign(intervalStartState.size() + 1, 0);
+
+  eventPreviousIntervals = compose(
+      eventStates, [&](index st) { return statePreviousInterval[st]; });
+  eventNextIntervals = compose(
+      eventStates, [&](index st) { return stateNextInterval[st]; });
+  timeSyncPreviousIntervals
+      = compose_all(timeSyncEvents, eventPreviousIntervals);
+  timeSyncNextIntervals = compose_all(timeSyncEvents, eventNextIntervals);
+}
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace Scenario
+{
+class IntervalModel;
+class EventModel;
+class TimeSyncModel;
+class StateModel;
+class ProcessModel;
+}
+
+namespace stal
+{
+/**
+ * @brief Read-only, index-based snapshot of a Scenario::ProcessModel.
+ *
+ * Every element gets a dense 32-bit index, in the iteration order of the
+ * scenario containers. Relations between elements are stored either as
+ * plain index arrays (one-to-one) or in compressed sparse row form
+ * (one-to-many), so that the analyses never have to go back through the
+ * id-keyed containers of the model.
+ *
+ * The snapshot is built once and can then be shared by every analysis.
+ * Nested scenarios get their own snapshot, reachable through
+ * intervalSubScenarios.
+ */
+struct ScenarioGraph
+{
+  using index = uint32_t;
+  static constexpr index none = std::numeric_limits<index>::max();
+
+  struct Adjacency
+  {
+    std::vector<index> offsets{0};
+    std::vector<index> values;
+
+    std::span<const index> operator[](index i) const noexcept
+    {
+      return {values.data() + offsets[i], values.data() + offsets[i + 1]};
+    }
+
+    std::size_t size() const noexcept { return offsets.size() - 1; }
+  };
+
+  struct SubScenario
+  {
+    const Scenario::ProcessModel* model{};
+    int32_t id{};
+    std::unique_ptr<ScenarioGraph> graph;
+  };
+
+  ScenarioGraph() = default;
+  explicit ScenarioGraph(
+      const Scenario::ProcessModel& scenar,
+      bool recursive = true);
+
+  ScenarioGraph(ScenarioGraph&&) noexcept = default;
+  ScenarioGraph& operator=(ScenarioGraph&&) noexcept = default;
+  ~ScenarioGraph();
+
+  //! Computes the derived adjacency lists from the base relations.
+  void link();
+
+  index startState(index itv) const noexcept
+  {
+    return intervalStartState[itv];
+  }
+  index endState(index itv) const noexcept { return intervalEndState[itv]; }
+  index startEvent(index itv) const noexcept
+  {
+    return stateEvent[intervalStartState[itv]];
+  }
+  index endEvent(index itv) const noexcept
+  {
+    return stateEvent[intervalEndState[itv]];
+  }
+  index startTimeSync(index itv) const noexcept
+  {
+    return eventTimeSync[startEvent(itv)];
+  }
+  index endTimeSync(index itv) const noexcept
+  {
+    return eventTimeSync[endEvent(itv)];
+  }
+
+  const Scenario::ProcessModel* model{};
+
+  std::vector<const Scenario::IntervalModel*> intervals;
+  std::vector<const Scenario::EventModel*> events;
+  std::vector<const Scenario::TimeSyncModel*> timeSyncs;
+  std::vector<const Scenario::StateModel*> states;
+
+  // Base relations
+  std::vector<index> intervalStartState;
+  std::vector<index> intervalEndState;
+  std::vector<index> statePreviousInterval; // none if there is no interval
+  std::vector<index> stateNextInterval;     // none if there is no interval
+  std::vector<index> stateEvent;
+  std::vector<index> eventTimeSync;
+  Adjacency eventStates;
+  Adjacency timeSyncEvents;
+
+  // Derived relations
+  Adjacency eventPreviousIntervals;
+  Adjacency eventNextIntervals;
+  Adjacency timeSyncPreviousIntervals;
+  Adjacency timeSyncNextIntervals;
+
+  // Element properties used by the analyses
+  std::vector<uint8_t> intervalRigid;
+  std::vector<uint8_t> eventHasCondition;
+  std::vector<uint8_t> timeSyncActive;
+  std::vector<uint8_t> timeSyncHasExpression;
+
+  index scenarioStart = none; // Start time sync of the scenario
+
+  // Hierarchy
+  std::vector<SubScenario> subScenarios;
+  Adjacency intervalSubScenarios;
+};
+}
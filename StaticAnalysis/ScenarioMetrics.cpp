@@ -1,5 +1,11 @@
 #include "ScenarioMetrics.hpp"
 
+#include "Commands.hpp"
+#include "DisjointSets.hpp"
+#include "ScenarioGraph.hpp"
+#include "ThreadPool.hpp"
+
+#include <Scenario/Commands/Metadata/ChangeElementLabel.hpp>
 #include <Scenario/Document/Event/EventModel.hpp>
 #include <Scenario/Document/Interval/IntervalModel.hpp>
 #include <Scenario/Document/State/StateModel.hpp>
@@ -7,17 +13,17 @@
 #include <Scenario/Process/Algorithms/Accessors.hpp>
 #include <Scenario/Process/ScenarioModel.hpp>
 
+#include <score/command/Dispatchers/MacroCommandDispatcher.hpp>
 #include <score/model/path/Path.hpp>
 
 #include <ossia/detail/algorithms.hpp>
+
+#include <array>
 namespace stal
 {
 class MLVisitor
 {
-  std::unordered_map<const Scenario::IntervalModel*, int> itv_ids;
-  std::unordered_map<const Scenario::EventModel*, int> ev_ids;
-  std::unordered_map<const Scenario::TimeSyncModel*, int> trig_ids;
-  std::unordered_map<const Process::ProcessModel*, int> proc_ids;
+  using index = ScenarioGraph::index;
   int cur_itv_id{};
   int cur_node_id{};
   int cur_proc_id{};
@@ -57,10 +63,10 @@ public:
     }
   };
 
-  void operator()(const Scenario::ProcessModel& proc)
+  void operator()(const ScenarioGraph& proc)
   {
     int id = ++cur_proc_id;
-    proc_ids.insert({&proc, id});
+    std::vector<int> itv_ids(proc.intervals.size());
 
     {
       with_brace _{this};
@@ -73,10 +79,10 @@ public:
         indent++;
         addLine("intervals = [ ");
 
-        for (auto& itv : proc.intervals)
+        for (index itv = 0; itv < proc.intervals.size(); itv++)
         {
           indent++;
-          visit(itv);
+          itv_ids[itv] = visit(proc, itv);
           text += "; ";
           indent--;
         }
@@ -84,10 +90,10 @@ public:
         text += "];\n";
 
         addLine("tempConds = [ ");
-        for (auto& tn : proc.timeSyncs)
+        for (index tn = 0; tn < proc.timeSyncs.size(); tn++)
         {
           indent++;
-          visit(tn, proc);
+          visit(proc, itv_ids, tn);
           text += "; ";
           indent--;
         }
@@ -106,10 +112,10 @@ public:
             };
     }*/
   }
-  void visit(const Scenario::IntervalModel& c)
+  int visit(const ScenarioGraph& proc, index itv)
   {
+    const Scenario::IntervalModel& c = *proc.intervals[itv];
     int id = ++cur_itv_id;
-    itv_ids.insert({&c, id});
 
     {
       with_brace _{this};
@@ -132,29 +138,27 @@ public:
       addLine("processes = [");
 
       {
-        for (auto& process : c.processes)
+        for (index sub : proc.intervalSubScenarios[itv])
         {
-          if (auto scenar = dynamic_cast<Scenario::ProcessModel*>(&process))
-          {
-            indent++;
-            (*this)(*scenar);
-            addLine("; ");
-            indent--;
-          }
+          indent++;
+          (*this)(*proc.subScenarios[sub].graph);
+          addLine("; ");
+          indent--;
         }
         finishList();
       }
       addLine("]");
     }
+    return id;
   }
 
   void visit(
-      const Scenario::EventModel& ev,
-      int parent,
-      const Scenario::ProcessModel& proc)
+      const ScenarioGraph& proc,
+      const std::vector<int>& itv_ids,
+      index ev,
+      int parent)
   {
     int id = ++cur_cond_id;
-    ev_ids.insert({&ev, id});
 
     {
       with_brace _{this};
@@ -164,10 +168,9 @@ public:
       {
         addLine("previousItv = [");
 
-        for (auto& itvid : Scenario::previousIntervals(ev, proc))
+        for (index itv : proc.eventPreviousIntervals[ev])
         {
-          auto& itv = proc.interval(itvid);
-          addLine("IntervalId " + QString::number(itv_ids.at(&itv)) + "; ");
+          addLine("IntervalId " + QString::number(itv_ids[itv]) + "; ");
         }
         finishList();
         addLine("];");
@@ -176,10 +179,9 @@ public:
       {
         addLine("nextItv = [");
 
-        for (auto& itvid : Scenario::nextIntervals(ev, proc))
+        for (index itv : proc.eventNextIntervals[ev])
         {
-          auto& itv = proc.interval(itvid);
-          addLine("IntervalId " + QString::number(itv_ids.at(&itv)) + "; ");
+          addLine("IntervalId " + QString::number(itv_ids[itv]) + "; ");
         }
         finishList();
         addLine("];");
@@ -197,11 +199,12 @@ public:
      */
   }
 
-  void
-  visit(const Scenario::TimeSyncModel& tn, const Scenario::ProcessModel& proc)
+  void visit(
+      const ScenarioGraph& proc,
+      const std::vector<int>& itv_ids,
+      index tn)
   {
     int id = ++cur_trig_id;
-    trig_ids.insert({&tn, id});
 
     /*{
       tcId = TempCondId 1;
@@ -215,11 +218,10 @@ public:
       addLine("syncExpr = true_expression;");
       addLine("conds = [");
 
-      for (auto& eid : tn.events())
+      for (index ev : proc.timeSyncEvents[tn])
       {
         indent++;
-        auto& ev = proc.event(eid);
-        visit(ev, id, proc);
+        visit(proc, itv_ids, ev, id);
         text += "; ";
         indent--;
       }
@@ -232,6 +234,11 @@ public:
 };
 
 QString stal::Metrics::toML(const Scenario::ProcessModel& s)
+{
+  return toML(ScenarioGraph{s});
+}
+
+QString stal::Metrics::toML(const ScenarioGraph& s)
 {
   MLVisitor m;
   m(s);
@@ -279,32 +286,34 @@ class LanguageVisitor;
 template <>
 class LanguageVisitor<Scenario::ProcessModel>
 {
+  using index = ScenarioGraph::index;
+
 public:
-  const Scenario::ProcessModel& m_scenar;
+  const ScenarioGraph& m_scenar;
   QString text;
 
-  LanguageVisitor(const Scenario::ProcessModel& scenar) : m_scenar{scenar}
+  LanguageVisitor(const ScenarioGraph& scenar) : m_scenar{scenar}
   {
     text += " {" + QString("\n");
 
-    for (const auto& elt : scenar.intervals)
+    for (index elt = 0; elt < scenar.intervals.size(); elt++)
     {
-      visit(elt);
+      visitInterval(elt);
     }
 
-    for (const auto& elt : scenar.events)
+    for (index elt = 0; elt < scenar.events.size(); elt++)
     {
-      visit(elt);
+      visitEvent(elt);
     }
 
-    for (const auto& elt : scenar.timeSyncs)
+    for (index elt = 0; elt < scenar.timeSyncs.size(); elt++)
     {
-      visit(elt);
+      visitTimeSync(elt);
     }
 
-    for (const auto& elt : scenar.states)
+    for (index elt = 0; elt < scenar.states.size(); elt++)
     {
-      visit(elt);
+      visitState(elt);
     }
 
     text += "}";
@@ -341,27 +350,27 @@ public:
     return s;
   }
 
-  void visit(const Scenario::IntervalModel& c)
+  void visitInterval(index itv)
   {
-    text += "interval " + id(c) + " after " + id(startState(c, m_scenar))
-            + QString("\n");
+    const Scenario::IntervalModel& c = *m_scenar.intervals[itv];
+    const auto& start = *m_scenar.states[m_scenar.startState(itv)];
+    text += "interval " + id(c) + " after " + id(start) + QString("\n");
     text += "duration " + duration(c) + " of " + id(c) + QString("\n");
 
-    for (auto& process : c.processes)
+    for (index sub : m_scenar.intervalSubScenarios[itv])
     {
-      if (auto scenar = dynamic_cast<Scenario::ProcessModel*>(&process))
-      {
-        text += "scenario " + id(*scenar)
-                + LanguageVisitor<Scenario::ProcessModel>{*scenar}.text
-                + " of " + id(c) + QString("\n");
-      }
+      const auto& scenar = m_scenar.subScenarios[sub];
+      text += "scenario " + id(*scenar.model)
+              + LanguageVisitor<Scenario::ProcessModel>{*scenar.graph}.text
+              + " of " + id(c) + QString("\n");
     }
   }
 
-  void visit(const Scenario::EventModel& e)
+  void visitEvent(index ev)
   {
-    text += "event " + id(e) + " of " + id(parentTimeSync(e, m_scenar))
-            + QString("\n");
+    const Scenario::EventModel& e = *m_scenar.events[ev];
+    const auto& tn = *m_scenar.timeSyncs[m_scenar.eventTimeSync[ev]];
+    text += "event " + id(e) + " of " + id(tn) + QString("\n");
 
     if (e.condition().childCount() > 0)
     {
@@ -370,8 +379,9 @@ public:
     }
   }
 
-  void visit(const Scenario::TimeSyncModel& tn)
+  void visitTimeSync(index ts)
   {
+    const Scenario::TimeSyncModel& tn = *m_scenar.timeSyncs[ts];
     text += "timeSync " + id(tn) + QString("\n");
 
     if (tn.expression().childCount() > 0)
@@ -381,16 +391,18 @@ public:
     }
   }
 
-  void visit(const Scenario::StateModel& st)
+  void visitState(index s)
   {
-    if (st.previousInterval())
+    const Scenario::StateModel& st = *m_scenar.states[s];
+    if (auto prev = m_scenar.statePreviousInterval[s];
+        prev != ScenarioGraph::none)
     {
-      text += "state " + id(st) + " after "
-              + id(previousInterval(st, m_scenar)) + QString("\n");
+      text += "state " + id(st) + " after " + id(*m_scenar.intervals[prev])
+              + QString("\n");
     }
 
-    text += "state " + id(st) + " of " + id(parentEvent(st, m_scenar))
-            + QString("\n");
+    text += "state " + id(st) + " of "
+            + id(*m_scenar.events[m_scenar.stateEvent[s]]) + QString("\n");
   }
 };
 
@@ -434,38 +446,26 @@ struct ScenarioFactors
   // Operands
   struct operands_t
   {
-    QMap<QString, int> variables;
-    std::vector<QMap<QString, int>> subprocesses_variables;
+    enum Kind
+    {
+      Interval,
+      Event,
+      TimeSync,
+      State,
+      Process, // By rank of the process id in the scope
+      KindCount
+    };
+    using offsets_t = std::array<std::size_t, KindCount>;
+
+    // Occurrences of the elements of every scope, by kind and by index.
+    // All the scopes share this arena : each one reserves a range per kind.
+    std::vector<int> variables;
     int expressions{};
     int interval_rigid_times{};
     int interval_minmax_times{};
-
-    std::vector<int> toVector() const
-    {
-      std::vector<int> v;
-
-      for (auto elt : variables)
-      {
-        v.push_back(elt);
-      }
-
-      for (auto vec : subprocesses_variables)
-      {
-        for (auto elt : vec)
-        {
-          v.push_back(elt);
-        }
-      }
-
-      v.push_back(expressions);
-      v.push_back(interval_rigid_times);
-      v.push_back(interval_minmax_times);
-
-      return v;
-    }
-
   } operands;
 
+  // The variables are not merged : all the scopes count them in one arena.
   ScenarioFactors& operator+=(const ScenarioFactors& other)
   {
     operators.scenario += other.operators.scenario;
@@ -483,21 +483,79 @@ struct ScenarioFactors
     operators.expression += other.operators.expression;
     operators.duration += other.operators.duration;
 
-    operands.subprocesses_variables.push_back(other.operands.variables);
-    ossia::copy(
-        other.operands.subprocesses_variables,
-        operands.subprocesses_variables);
-
     operands.expressions += other.operands.expressions;
     operands.interval_rigid_times += other.operands.interval_rigid_times;
     operands.interval_minmax_times += other.operands.interval_minmax_times;
 
     return *this;
-    // TODO -Werror=return-type
   }
 };
 
-static int sum_unique(const std::vector<int>& vec)
+// A scenario of the hierarchy, with the place of its counters in the arena.
+struct HalsteadScope
+{
+  const ScenarioGraph* graph{};
+  ScenarioFactors::operands_t::offsets_t offsets{};
+  // Rank of the process id of each sub-scenario in the scope
+  std::vector<ScenarioGraph::index> processKey;
+  // Scope of each sub-scenario, NoScope if it is not in the graph
+  std::vector<std::size_t> subScopes;
+  // Counts of this scope only, but for the variables
+  ScenarioFactors factors;
+};
+
+static const constexpr std::size_t NoScope = -1;
+
+// Lists the scopes depth-first and lays out their counters in the arena.
+// Sub-scenarios which are not in the graph get no scope.
+static std::size_t collectScopes(
+    const ScenarioGraph& scenar,
+    std::vector<HalsteadScope>& scopes,
+    std::size_t& arena)
+{
+  using operands_t = ScenarioFactors::operands_t;
+  const std::size_t self = scopes.size();
+  scopes.emplace_back();
+
+  // Processes of different intervals may share their id :
+  // they are then the same operand.
+  std::vector<int32_t> ids;
+  ids.reserve(scenar.subScenarios.size());
+  for (const auto& sub : scenar.subScenarios)
+    ids.push_back(sub.id);
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  auto& scope = scopes[self];
+  scope.graph = &scenar;
+  scope.processKey.reserve(scenar.subScenarios.size());
+  for (const auto& sub : scenar.subScenarios)
+    scope.processKey.push_back(
+        std::lower_bound(ids.begin(), ids.end(), sub.id) - ids.begin());
+
+  const operands_t::offsets_t sizes{
+      scenar.intervals.size(),
+      scenar.events.size(),
+      scenar.timeSyncs.size(),
+      scenar.states.size(),
+      ids.size()};
+  for (std::size_t k = 0; k < operands_t::KindCount; k++)
+  {
+    scope.offsets[k] = arena;
+    arena += sizes[k];
+  }
+
+  std::vector<std::size_t> subScopes;
+  subScopes.reserve(scenar.subScenarios.size());
+  for (const auto& sub : scenar.subScenarios)
+    subScopes.push_back(
+        sub.graph ? collectScopes(*sub.graph, scopes, arena) : NoScope);
+  scopes[self].subScopes = std::move(subScopes);
+
+  return self;
+}
+
+static int sum_unique(std::span<const int> vec)
 {
   int val = 0;
   for (int e : vec)
@@ -507,7 +565,7 @@ static int sum_unique(const std::vector<int>& vec)
   return val;
 }
 
-static int sum_all(const std::vector<int>& vec)
+static int sum_all(std::span<const int> vec)
 {
   return std::accumulate(vec.begin(), vec.end(), 0);
 }
@@ -517,47 +575,65 @@ class HalsteadVisitor;
 template <>
 class HalsteadVisitor<Scenario::ProcessModel>
 {
-public:
-  const Scenario::ProcessModel& m_scenar;
-  ScenarioFactors f;
+  using index = ScenarioGraph::index;
 
-  HalsteadVisitor(const Scenario::ProcessModel& scenar) : m_scenar{scenar}
+public:
+  using operands_t = ScenarioFactors::operands_t;
+
+  std::vector<HalsteadScope>& m_scopes;
+  const HalsteadScope& m_scope;
+  const ScenarioGraph& m_scenar;
+  ScenarioFactors& f;
+  std::vector<int>& m_arena;
+  TaskGroup& m_tasks;
+
+  // Each scope only writes in its own counters : the nested scenarios
+  // are visited concurrently, as tasks of the same group.
+  HalsteadVisitor(
+      std::vector<HalsteadScope>& scopes,
+      std::size_t scope,
+      std::vector<int>& arena,
+      TaskGroup& tasks)
+      : m_scopes{scopes}
+      , m_scope{scopes[scope]}
+      , m_scenar{*scopes[scope].graph}
+      , f{scopes[scope].factors}
+      , m_arena{arena}
+      , m_tasks{tasks}
   {
     f.operators.lbrace += 1;
 
-    for (const auto& elt : scenar.intervals)
+    for (index elt = 0; elt < m_scenar.intervals.size(); elt++)
     {
-      visit(elt);
+      visitInterval(elt);
     }
 
-    for (const auto& elt : scenar.events)
+    for (index elt = 0; elt < m_scenar.events.size(); elt++)
     {
-      visit(elt);
+      visitEvent(elt);
     }
 
-    for (const auto& elt : scenar.timeSyncs)
+    for (index elt = 0; elt < m_scenar.timeSyncs.size(); elt++)
     {
-      visit(elt);
+      visitTimeSync(elt);
     }
 
-    for (const auto& elt : scenar.states)
+    for (index elt = 0; elt < m_scenar.states.size(); elt++)
     {
-      visit(elt);
+      visitState(elt);
     }
 
     f.operators.rbrace += 1;
   }
 
-  template <typename T>
-  QString id(const T& c)
+  void use(operands_t::Kind kind, index elt)
   {
-    return QString(Metadata<Description_k, T>::get())
-           + QString::number(c.id_val());
+    m_arena[m_scope.offsets[kind] + elt] += 1;
   }
 
-  void duration(const Scenario::IntervalModel& c)
+  void duration(index itv)
   {
-    if (c.duration.isRigid())
+    if (m_scenar.intervalRigid[itv])
     {
       f.operands.interval_rigid_times += 1;
     }
@@ -567,78 +643,90 @@ public:
     }
   }
 
-  void visit(const Scenario::IntervalModel& c)
+  void visitInterval(index itv)
   {
     f.operators.interval += 1;
-    f.operands.variables[id(c)] += 1;
+    use(operands_t::Interval, itv);
     f.operators.after += 1;
-    f.operands.variables[id(startState(c, m_scenar))] += 1;
+    use(operands_t::State, m_scenar.startState(itv));
 
     f.operators.duration += 1;
     f.operators.of += 1;
-    f.operands.variables[id(c)] += 1;
+    use(operands_t::Interval, itv);
 
-    for (auto& process : c.processes)
+    for (index sub : m_scenar.intervalSubScenarios[itv])
     {
-      if (auto scenar = dynamic_cast<Scenario::ProcessModel*>(&process))
+      f.operators.scenario += 1;
+      use(operands_t::Process, m_scope.processKey[sub]);
+      if (const auto child = m_scope.subScopes[sub]; child != NoScope)
       {
-        f.operators.scenario += 1;
-        f.operands.variables[id(*scenar)] += 1;
-        f += HalsteadVisitor<Scenario::ProcessModel>{*scenar}.f;
-        f.operators.of += 1;
-        f.operands.variables[id(c)] += 1;
+        m_tasks.run([&scopes = m_scopes,
+                     &arena = m_arena,
+                     &tasks = m_tasks,
+                     child] {
+          HalsteadVisitor<Scenario::ProcessModel>{
+              scopes, child, arena, tasks};
+        });
       }
+      f.operators.of += 1;
+      use(operands_t::Interval, itv);
     }
   }
 
-  void visit(const Scenario::EventModel& e)
+  void visitEvent(index ev)
   {
     f.operators.event += 1;
-    f.operands.variables[id(e)] += 1;
+    use(operands_t::Event, ev);
     f.operators.of += 1;
-    f.operands.variables[id(parentTimeSync(e, m_scenar))] += 1;
+    use(operands_t::TimeSync, m_scenar.eventTimeSync[ev]);
 
-    if (e.condition().childCount() > 0)
+    if (m_scenar.eventHasCondition[ev])
     {
       f.operators.expression += 1;
       f.operands.expressions += 1;
       f.operators.of += 1;
-      f.operands.variables[id(e)] += 1;
+      use(operands_t::Event, ev);
     }
   }
 
-  void visit(const Scenario::TimeSyncModel& tn)
+  void visitTimeSync(index ts)
   {
     f.operators.timeSync += 1;
-    f.operands.variables[id(tn)] += 1;
+    use(operands_t::TimeSync, ts);
 
-    if (tn.expression().childCount() > 0)
+    if (m_scenar.timeSyncHasExpression[ts])
     {
       f.operators.expression += 1;
       f.operands.expressions += 1;
       f.operators.of += 1;
-      f.operands.variables[id(tn)] += 1;
+      use(operands_t::TimeSync, ts);
     }
   }
 
-  void visit(const Scenario::StateModel& st)
+  void visitState(index s)
   {
-    if (st.previousInterval())
+    if (auto prev = m_scenar.statePreviousInterval[s];
+        prev != ScenarioGraph::none)
     {
       f.operators.state += 1;
-      f.operands.variables[id(st)] += 1;
+      use(operands_t::State, s);
       f.operators.after += 1;
-      f.operands.variables[id(previousInterval(st, m_scenar))] += 1;
+      use(operands_t::Interval, prev);
     }
 
     f.operators.state += 1;
-    f.operands.variables[id(st)] += 1;
+    use(operands_t::State, s);
     f.operators.of += 1;
-    f.operands.variables[id(parentEvent(st, m_scenar))] += 1;
+    use(operands_t::Event, m_scenar.stateEvent[s]);
   }
 };
 
 QString stal::Metrics::toScenarioLanguage(const Scenario::ProcessModel& s)
+{
+  return toScenarioLanguage(ScenarioGraph{s});
+}
+
+QString stal::Metrics::toScenarioLanguage(const ScenarioGraph& s)
 {
   return LanguageVisitor<Scenario::ProcessModel>{s}.text;
 }
@@ -646,12 +734,72 @@ QString stal::Metrics::toScenarioLanguage(const Scenario::ProcessModel& s)
 stal::Metrics::Halstead::Factors
 stal::Metrics::Halstead::ComputeFactors(const Scenario::ProcessModel& scenar)
 {
-  auto sf = HalsteadVisitor<Scenario::ProcessModel>{scenar}.f;
+  return ComputeFactors(ScenarioGraph{scenar});
+}
+
+stal::Metrics::Halstead::Counts&
+stal::Metrics::Halstead::Counts::operator+=(const Counts& other) noexcept
+{
+  for (std::size_t i = 0; i < operators.size(); i++)
+    operators[i] += other.operators[i];
+  uniqueVariables += other.uniqueVariables;
+  variables += other.variables;
+  expressions += other.expressions;
+  intervalRigidTimes += other.intervalRigidTimes;
+  intervalMinMaxTimes += other.intervalMinMaxTimes;
+  return *this;
+}
+
+stal::Metrics::Halstead::Counts
+stal::Metrics::Halstead::ComputeCounts(const ScenarioGraph& scenar)
+{
+  std::vector<HalsteadScope> scopes;
+  std::size_t arena_size = 0;
+  collectScopes(scenar, scopes, arena_size);
+
+  ScenarioFactors sf;
+  sf.operands.variables.resize(arena_size);
+  {
+    TaskGroup tasks;
+    HalsteadVisitor<Scenario::ProcessModel>{
+        scopes, 0, sf.operands.variables, tasks};
+    tasks.wait();
+  }
+
+  // Merged in the order of the scopes, whatever the order of the tasks.
+  for (const auto& scope : scopes)
+    sf += scope.factors;
+
+  Counts counts;
+  const auto operators = sf.operators.toVector();
+  std::copy(operators.begin(), operators.end(), counts.operators.begin());
+  counts.uniqueVariables = sum_unique(sf.operands.variables);
+  counts.variables = sum_all(sf.operands.variables);
+  counts.expressions = sf.operands.expressions;
+  counts.intervalRigidTimes = sf.operands.interval_rigid_times;
+  counts.intervalMinMaxTimes = sf.operands.interval_minmax_times;
+  return counts;
+}
+
+stal::Metrics::Halstead::Factors
+stal::Metrics::Halstead::ComputeFactors(const ScenarioGraph& scenar)
+{
+  return ComputeFactors(ComputeCounts(scenar));
+}
+
+stal::Metrics::Halstead::Factors
+stal::Metrics::Halstead::ComputeFactors(const Counts& counts)
+{
+  const std::array<int, 3> other_operands{
+      counts.expressions,
+      counts.intervalRigidTimes,
+      counts.intervalMinMaxTimes};
+
   stal::Metrics::Halstead::Factors factors;
-  factors.eta1 = sum_unique(sf.operators.toVector());
-  factors.eta2 = sum_unique(sf.operands.toVector());
-  factors.N1 = sum_all(sf.operators.toVector());
-  factors.N2 = sum_all(sf.operands.toVector());
+  factors.eta1 = sum_unique(counts.operators);
+  factors.eta2 = counts.uniqueVariables + sum_unique(other_operands);
+  factors.N1 = sum_all(counts.operators);
+  factors.N2 = counts.variables + sum_all(other_operands);
   return factors;
 }
 
@@ -815,168 +963,101 @@ m_scenar))
 };
 */
 
+using index = ScenarioGraph::index;
+
 struct Program
 {
-  std::vector<Id<Scenario::IntervalModel>> intervals;
-  std::vector<Id<Scenario::EventModel>> events;
-  std::vector<Id<Scenario::TimeSyncModel>> nodes;
-  std::vector<Id<Scenario::StateModel>> states;
+  std::vector<index> intervals;
+  std::vector<index> events;
+  std::vector<index> nodes;
+  std::vector<index> states;
 };
 
 using Mark = int;
 static const constexpr int NoMark = -1;
-// A program is a connected set of intervals, etc.
-class ProgramVisitor
+// Distributes the marked elements in their groups with a counting sort :
+// one pass to size each group, one pass to fill them in index order.
+template <typename Group>
+static void bucket(
+    const std::vector<Mark>& marks,
+    std::vector<Group>& groups,
+    std::vector<index> Group::*member)
 {
-  Mark currentMark = 0;
-
-  std::map<Id<Scenario::IntervalModel>, Mark> intervals;
-  std::map<Id<Scenario::EventModel>, Mark> events;
-  std::map<Id<Scenario::TimeSyncModel>, Mark> nodes;
-  std::map<Id<Scenario::StateModel>, Mark> states;
-
-  const Scenario::ProcessModel& m_scenar;
-
-public:
-  ProgramVisitor(const Scenario::ProcessModel& scenar) : m_scenar{scenar}
+  std::vector<index> count(groups.size());
+  for (Mark m : marks)
   {
-    for (const auto& elt : scenar.intervals)
-    {
-      intervals.insert(std::make_pair(elt.id(), NoMark));
-    }
-    for (const auto& elt : scenar.timeSyncs)
-    {
-      nodes.insert(std::make_pair(elt.id(), NoMark));
-    }
-    for (const auto& elt : scenar.events)
-    {
-      events.insert(std::make_pair(elt.id(), NoMark));
-    }
-    for (const auto& elt : scenar.states)
-    {
-      states.insert(std::make_pair(elt.id(), NoMark));
-    }
-
-    // Take a interval and recursively mark everything
-    for (const auto& interval : scenar.intervals)
-    {
-      if (intervals.at(interval.id()) == NoMark)
-      {
-        mark(interval.id(), currentMark);
-        currentMark++;
-      }
-    }
+    if (m != NoMark)
+      count[m]++;
   }
 
-  std::vector<Program> programs()
+  for (std::size_t g = 0; g < groups.size(); g++)
   {
-    std::vector<Program> prog;
-    prog.reserve(currentMark);
-    for (Mark m = 0; m < currentMark; m++)
-    {
-      Program p;
-
-      for (const auto& elt : intervals)
-      {
-        if (elt.second == m)
-        {
-          p.intervals.push_back(elt.first);
-        }
-      }
-
-      for (const auto& elt : events)
-      {
-        if (elt.second == m)
-        {
-          p.events.push_back(elt.first);
-        }
-      }
-
-      for (const auto& elt : nodes)
-      {
-        if (elt.second == m)
-        {
-          p.nodes.push_back(elt.first);
-        }
-      }
-
-      for (const auto& elt : states)
-      {
-        if (elt.second == m)
-        {
-          p.states.push_back(elt.first);
-        }
-      }
-
-      prog.push_back(std::move(p));
-    }
-
-    return prog;
+    (groups[g].*member).reserve(count[g]);
   }
 
-private:
-  void mark(const Id<Scenario::IntervalModel>& cid, Mark m)
+  for (index elt = 0; elt < marks.size(); elt++)
   {
-    SCORE_ASSERT(intervals.at(cid) == m || intervals.at(cid) == NoMark);
-    if (intervals.at(cid) == m)
-    {
-      return;
-    }
-
-    intervals.at(cid) = m;
+    if (const Mark m = marks[elt]; m != NoMark)
+      (groups[m].*member).push_back(elt);
+  }
+}
 
-    auto& cst = m_scenar.intervals.at(cid);
-    states.at(startState(cst, m_scenar).id()) = m;
-    states.at(endState(cst, m_scenar).id()) = m;
-    events.at(startEvent(cst, m_scenar).id()) = m;
-    events.at(endEvent(cst, m_scenar).id()) = m;
-    nodes.at(startTimeSync(cst, m_scenar).id()) = m;
-    nodes.at(endTimeSync(cst, m_scenar).id()) = m;
+// A program is a connected set of intervals, etc.
+class ProgramVisitor
+{
+  Mark currentMark = 0;
 
-    // Mark all that's before the start node.
-    auto& start_node = startTimeSync(cst, m_scenar);
-    for (const auto& cst : previousIntervals(start_node, m_scenar))
-    {
-      mark(cst, m);
-    }
+  std::vector<Mark> intervals;
+  std::vector<Mark> events;
+  std::vector<Mark> nodes;
+  std::vector<Mark> states;
 
-    // Mark all that's after the start node.
-    for (const auto& cst : nextIntervals(start_node, m_scenar))
+public:
+  ProgramVisitor(const ScenarioGraph& scenar)
+      : intervals(scenar.intervals.size(), NoMark)
+      , events(scenar.events.size(), NoMark)
+      , nodes(scenar.timeSyncs.size(), NoMark)
+      , states(scenar.states.size(), NoMark)
+  {
+    // Two intervals are in the same program if they are linked through
+    // time syncs : the programs are the connected components of the graph
+    // whose vertices are the time syncs and whose edges are the intervals.
+    DisjointSets components{scenar.timeSyncs.size()};
+    for (index itv = 0; itv < intervals.size(); itv++)
     {
-      mark(cst, m);
+      components.unite(scenar.startTimeSync(itv), scenar.endTimeSync(itv));
     }
 
-    // Mark all that's before the end node.
-    auto& end_node = endTimeSync(cst, m_scenar);
-    for (const auto& cst : previousIntervals(end_node, m_scenar))
+    // Programs are numbered in the order of their first interval.
+    std::vector<Mark> componentMark(scenar.timeSyncs.size(), NoMark);
+    for (index itv = 0; itv < intervals.size(); itv++)
     {
-      mark(cst, m);
-    }
+      Mark& m = componentMark[components.find(scenar.startTimeSync(itv))];
+      if (m == NoMark)
+      {
+        m = currentMark++;
+      }
 
-    // Mark all that's after the end node.
-    for (const auto& cst : nextIntervals(end_node, m_scenar))
-    {
-      mark(cst, m);
+      intervals[itv] = m;
+      states[scenar.startState(itv)] = m;
+      states[scenar.endState(itv)] = m;
+      events[scenar.startEvent(itv)] = m;
+      events[scenar.endEvent(itv)] = m;
+      nodes[scenar.startTimeSync(itv)] = m;
+      nodes[scenar.endTimeSync(itv)] = m;
     }
   }
-};
 
-static auto startingtimeSyncs(
-    const Program& program,
-    const Scenario::ProcessModel& scenario)
-{
-  std::list<Id<Scenario::TimeSyncModel>> startingNodes;
-  for (const auto& node_id : program.nodes)
+  std::vector<Program> programs() const
   {
-    const auto& node = scenario.timeSyncs.at(node_id);
-    auto csts = previousIntervals(node, scenario);
-    if (csts.empty())
-    {
-      startingNodes.push_back(node_id);
-    }
+    std::vector<Program> prog(currentMark);
+    bucket(intervals, prog, &Program::intervals);
+    bucket(events, prog, &Program::events);
+    bucket(nodes, prog, &Program::nodes);
+    bucket(states, prog, &Program::states);
+    return prog;
   }
-  return startingNodes;
-}
+};
 
 // For each starting point we propagate the flow in blocks in the following
 // fashion : Each condition yields a new block. Each timeSync with a trigger
@@ -984,323 +1065,240 @@ static auto startingtimeSyncs(
 // single block before a timeSync, and if there is no trigger / condition, then
 // the block continues afterwards.
 
-struct BaseBlock
-{
-  BaseBlock(int b) : block{b} {}
-  int block{};
-  std::vector<Id<Scenario::IntervalModel>> intervals;
-  std::vector<Id<Scenario::EventModel>> events;
-  std::vector<Id<Scenario::TimeSyncModel>> nodes;
-};
-
+// Here the mark refers to the block id of the group of elements.
 class CyclomaticVisitor
 {
-  // Here the mark refers to the block id of the group of elements.
-  Mark maxMark = 0;
+  Metrics::Cyclomatic::BlockGraph& m_blocks;
+  const ScenarioGraph& m_scenar;
+  Mark m_program = NoMark;
 
-  std::map<Id<Scenario::IntervalModel>, Mark> intervals;
-  std::map<Id<Scenario::EventModel>, Mark> events;
-  std::map<Id<Scenario::TimeSyncModel>, Mark> nodes;
+  // Number of previous intervals of each node that are not marked yet.
+  std::vector<index> pending;
+  // Nodes whose previous intervals are all marked, in visit order.
+  std::vector<index> worklist;
 
 public:
-  const Program& m_program;
-  const Scenario::ProcessModel& m_scenar;
-
   CyclomaticVisitor(
-      const Program& program,
-      const Scenario::ProcessModel& scenar)
-      : m_program{program}, m_scenar{scenar}
+      const ScenarioGraph& scenar,
+      Metrics::Cyclomatic::BlockGraph& blocks)
+      : m_blocks{blocks}, m_scenar{scenar}, pending(scenar.timeSyncs.size(), 0)
   {
-    using namespace Scenario;
+    m_blocks.intervalBlock.assign(scenar.intervals.size(), NoMark);
+    m_blocks.eventBlock.assign(scenar.events.size(), NoMark);
+    m_blocks.timeSyncBlock.assign(scenar.timeSyncs.size(), NoMark);
+  }
 
-    for (const auto& elt : scenar.intervals)
-    {
-      intervals.insert(std::make_pair(elt.id(), NoMark));
-    }
-    for (const auto& elt : scenar.timeSyncs)
-    {
-      nodes.insert(std::make_pair(elt.id(), NoMark));
-    }
-    for (const auto& elt : scenar.events)
+  // The blocks of the program are numbered after those of the previous ones.
+  void operator()(const Program& program)
+  {
+    m_program++;
+
+    // The marks flow forward over the time syncs, like a topological sort :
+    // a node is visited once, when the last of its previous intervals gets
+    // its mark, and everything it needs to know is known at this point.
+    worklist.reserve(program.nodes.size());
+    for (index node : program.nodes)
     {
-      events.insert(std::make_pair(elt.id(), NoMark));
+      pending[node] = m_scenar.timeSyncPreviousIntervals[node].size();
+      if (pending[node] == 0)
+        worklist.push_back(node);
     }
+    propagate();
 
-    std::list<Id<TimeSyncModel>> startingNodes
-        = startingtimeSyncs(program, scenar);
-    std::list<Id<EventModel>> startingEvents;
-    while (!startingNodes.empty() || !startingEvents.empty())
+    // A cycle of intervals never gets to zero : its nodes start new blocks.
+    for (index node : program.nodes)
     {
-      while (!startingNodes.empty())
-      {
-        auto node_id = *startingNodes.begin();
-        auto val = computeNode(node_id, maxMark);
-
-        std::list<Id<TimeSyncModel>> newNodes(
-            val.first.begin(), val.first.end());
-        startingNodes.splice(startingNodes.end(), newNodes);
-        startingNodes.remove(node_id);
-
-        std::list<Id<EventModel>> newEvents(
-            val.second.begin(), val.second.end());
-        startingEvents.splice(startingEvents.end(), newEvents);
-
-        maxMark++;
-      }
-
-      while (!startingEvents.empty())
+      if (m_blocks.timeSyncBlock[node] == NoMark)
       {
-        auto event_id = *startingEvents.begin();
-        auto val = computeEvent(event_id, maxMark);
-
-        std::list<Id<TimeSyncModel>> newNodes(
-            val.first.begin(), val.first.end());
-        startingNodes.splice(startingNodes.end(), newNodes);
-
-        std::list<Id<EventModel>> newEvents(
-            val.second.begin(), val.second.end());
-        startingEvents.splice(startingEvents.end(), newEvents);
-        startingEvents.remove(event_id);
-
-        maxMark++;
+        pending[node] = 0;
+        worklist.push_back(node);
+        propagate();
       }
     }
+
+    m_blocks.programBlocks.push_back(m_blocks.blockCount());
   }
 
-  std::vector<BaseBlock> blocks() const
+private:
+  Mark newBlock()
   {
-    std::vector<BaseBlock> blocks;
+    m_blocks.blockProgram.push_back(m_program);
+    return m_blocks.blockCount() - 1;
+  }
 
-    for (Mark m = 0; m < maxMark; m++)
+  void propagate()
+  {
+    for (std::size_t i = 0; i < worklist.size(); i++)
     {
-      BaseBlock b{m};
+      const index node = worklist[i];
+      const Mark m = nodeMark(node);
+      m_blocks.timeSyncBlock[node] = m;
 
-      for (const auto& elt : intervals)
+      // For each event, if they have a condition, they introduce a new mark
+      for (index event : m_scenar.timeSyncEvents[node])
       {
-        if (elt.second == m)
+        const Mark event_mark = eventIsInSameBlock(event) ? m : newBlock();
+        m_blocks.eventBlock[event] = event_mark;
+        for (index itv : m_scenar.eventNextIntervals[event])
         {
-          b.intervals.push_back(elt.first);
-        }
-      }
-
-      for (const auto& elt : events)
-      {
-        if (elt.second == m)
-        {
-          b.events.push_back(elt.first);
+          markInterval(itv, event_mark);
         }
       }
+    }
+    worklist.clear();
+  }
 
-      for (const auto& elt : nodes)
+  // The block of a node continues the block of its previous intervals if
+  // there is no trigger and if they all are in the same block.
+  Mark nodeMark(index tn)
+  {
+    if (!m_scenar.timeSyncActive[tn])
+    {
+      const auto& intervals = m_blocks.intervalBlock;
+      const auto prev_csts = m_scenar.timeSyncPreviousIntervals[tn];
+      if (!prev_csts.empty())
       {
-        if (elt.second == m)
+        const Mark m = intervals[prev_csts.front()];
+        if (m != NoMark && ossia::all_of(prev_csts, [&](index cst) {
+              return intervals[cst] == m;
+            }))
         {
-          b.nodes.push_back(elt.first);
+          return m;
         }
       }
-
-      blocks.push_back(std::move(b));
-    }
-    return blocks;
-  }
-  std::pair<
-      std::set<Id<Scenario::TimeSyncModel>>,
-      std::set<Id<Scenario::EventModel>>>
-  computeEvent(const Id<Scenario::EventModel>& event, Mark m)
-  {
-    using namespace Scenario;
-    std::set<Id<TimeSyncModel>> notSame, prev_notSame;
-    std::set<Id<TimeSyncModel>> notSure, prev_notSure;
-    std::set<Id<EventModel>> notSameEvent, prev_notSameEvent;
-
-    events.at(event) = m;
-    const auto& ev = m_scenar.events.at(event);
-    for (const auto& cid : nextIntervals(ev, m_scenar))
-    {
-      mark(cid, m, notSame, notSure, notSameEvent);
     }
-    return iterate(m, notSame, notSure, notSameEvent);
+    return newBlock();
   }
 
-  std::pair<
-      std::set<Id<Scenario::TimeSyncModel>>,
-      std::set<Id<Scenario::EventModel>>>
-  computeNode(const Id<Scenario::TimeSyncModel>& node, Mark m)
+  bool eventIsInSameBlock(index ev)
   {
-    using namespace Scenario;
-    std::set<Id<TimeSyncModel>> notSame;
-    std::set<Id<TimeSyncModel>> notSure;
-    std::set<Id<EventModel>> notSameEvent;
-    mark(node, m, notSame, notSure, notSameEvent);
-    return iterate(m, notSame, notSure, notSameEvent);
+    return !m_scenar.eventHasCondition[ev];
   }
 
-  std::pair<
-      std::set<Id<Scenario::TimeSyncModel>>,
-      std::set<Id<Scenario::EventModel>>>
-  iterate(
-      Mark m,
-      std::set<Id<Scenario::TimeSyncModel>>& notSame,
-      std::set<Id<Scenario::TimeSyncModel>>& notSure,
-      std::set<Id<Scenario::EventModel>>& notSameEvent)
+  void markInterval(index id, Mark m)
   {
-    using namespace Scenario;
-    std::set<Id<TimeSyncModel>> prev_notSame;
-    std::set<Id<TimeSyncModel>> prev_notSure;
-    std::set<Id<EventModel>> prev_notSameEvent;
-    do
+    m_blocks.intervalBlock[id] = m;
+
+    const index endNode = m_scenar.endTimeSync(id);
+    if (pending[endNode] != 0 && --pending[endNode] == 0)
     {
-      // As long as we gain new information, we iterate.
-      prev_notSame = notSame;
-      prev_notSure = notSure;
-      prev_notSameEvent = notSameEvent;
+      worklist.push_back(endNode);
+    }
+  }
+};
 
-      for (const auto& id : notSure)
-      {
-        // We check again since this may have changed
-        auto newState = timeSyncIsInSameBlock(m_scenar.timeSyncs.at(id), m);
+struct BaseBlock
+{
+  std::vector<index> intervals;
+  std::vector<index> nodes;
+};
 
-        switch (newState)
-        {
-          case NodeInBlock::Same:
-            notSure.erase(id);
-            mark(id, m, notSame, notSure, notSameEvent);
-            break;
-          case NodeInBlock::NotSure:
-            // do nothing
-            break;
-          case NodeInBlock::NotSame:
-            notSame.insert(id);
-            notSure.erase(id);
-            break;
-        }
-      }
-    } while (prev_notSame != notSame || prev_notSure != notSure
-             || prev_notSameEvent != notSameEvent);
+// Links each block to the blocks that its intervals and its events lead to.
+static void
+computeSuccessors(const ScenarioGraph& scenar, Metrics::Cyclomatic::BlockGraph& g)
+{
+  using Edge = Metrics::Cyclomatic::BlockGraph::Edge;
+  using EdgeKind = Metrics::Cyclomatic::BlockGraph::EdgeKind;
 
-    // Now we should have reached our limits.
-    notSame.insert(notSure.begin(), notSure.end());
-    notSure.clear();
+  std::vector<BaseBlock> blocks(g.blockCount());
+  bucket(g.intervalBlock, blocks, &BaseBlock::intervals);
+  bucket(g.timeSyncBlock, blocks, &BaseBlock::nodes);
 
-    return std::make_pair(notSame, notSameEvent);
-  }
+  // Last block which got an edge to a given (block, kind) pair.
+  std::vector<Mark> seen(2 * g.blockCount(), NoMark);
 
-  // Three levels :
-  //  in same block,
-  //  not sure (some intervals are unmarked),
-  //  not in same block
-  enum class NodeInBlock
-  {
-    Same,
-    NotSure,
-    NotSame
-  };
-  NodeInBlock
-  timeSyncIsInSameBlock(const Scenario::TimeSyncModel& tn, Mark mark)
+  g.successorOffsets.reserve(g.blockCount() + 1);
+  for (Mark b = 0; b < std::ssize(blocks); b++)
   {
-    // True if no condition,
-    // or if previous intervals are from different blocks
-    if (tn.active())
-      return NodeInBlock::NotSame;
-
-    auto prev_csts = previousIntervals(tn, m_scenar);
-    if (ossia::any_of(prev_csts, [&](const auto& cst) {
-          auto interval_mark = intervals.at(cst);
-          return interval_mark != mark && interval_mark != NoMark;
-        }))
-    {
-      return NodeInBlock::NotSame;
-    }
-    else if (ossia::any_of(prev_csts, [&](const auto& cst) {
-               auto interval_mark = intervals.at(cst);
-               return interval_mark != mark && interval_mark == NoMark;
-             }))
+    auto addEdge = [&](Mark next, EdgeKind kind) {
+      if (next == NoMark || next == b)
+        return;
+
+      Mark& last = seen[2 * next + int(kind)];
+      if (last != b)
+      {
+        last = b;
+        g.successorEdges.push_back(Edge{next, kind});
+      }
+    };
+
+    for (index itv : blocks[b].intervals)
     {
-      return NodeInBlock::NotSure;
+      addEdge(g.timeSyncBlock[scenar.endTimeSync(itv)], EdgeKind::Enabled);
     }
-    else
+    for (index node : blocks[b].nodes)
     {
-      return NodeInBlock::Same;
+      for (index event : scenar.timeSyncEvents[node])
+      {
+        // Twice for the disabled part
+        addEdge(g.eventBlock[event], EdgeKind::Enabled);
+        addEdge(g.eventBlock[event], EdgeKind::Disabled);
+      }
     }
+    g.successorOffsets.push_back(g.successorEdges.size());
   }
+}
 
-  bool eventIsInSameBlock(const Scenario::EventModel& ev)
+stal::Metrics::Cyclomatic::BlockGraph
+stal::Metrics::Cyclomatic::ComputeBlocks(const ScenarioGraph& scenar)
+{
+  BlockGraph g;
+  CyclomaticVisitor vis{scenar, g};
+  for (const auto& program : ProgramVisitor{scenar}.programs())
   {
-    return !ev.condition().hasChildren();
+    vis(program);
   }
 
-  void mark(
-      const Id<Scenario::TimeSyncModel>& id,
-      Mark m,
-      std::set<Id<Scenario::TimeSyncModel>>& notSame,
-      std::set<Id<Scenario::TimeSyncModel>>& notSure,
-      std::set<Id<Scenario::EventModel>>& notSameEvent)
-  {
-    // We flow for as long as we can and stop once
-    // new blocks are encountered
-    const auto& tn = m_scenar.timeSyncs.at(id);
-    nodes.at(id) = m;
+  computeSuccessors(scenar, g);
+  return g;
+}
 
-    // For each event, if they have a condition, they introduce a new mark
-    for (const auto& event_id : tn.events())
-    {
-      mark(event_id, m, notSame, notSure, notSameEvent);
-    }
-  }
+QString stal::Metrics::Cyclomatic::BlockLabel(
+    const BlockGraph& blocks,
+    int32_t block)
+{
+  const Mark program = blocks.blockProgram[block];
+  return QString::number(program) + " - "
+         + QString::number(block - (Mark)blocks.programBlocks[program]);
+}
 
-  void mark(
-      const Id<Scenario::EventModel>& event_id,
-      Mark m,
-      std::set<Id<Scenario::TimeSyncModel>>& notSame,
-      std::set<Id<Scenario::TimeSyncModel>>& notSure,
-      std::set<Id<Scenario::EventModel>>& notSameEvent)
+template <typename T>
+static void submitLabels(
+    MacroCommandDispatcher<LabelBlocks>& disp,
+    const std::vector<const T*>& elements,
+    const std::vector<Mark>& elementBlock,
+    const Metrics::Cyclomatic::BlockGraph& blocks)
+{
+  for (index i = 0; i < elements.size(); i++)
   {
-    // We flow for as long as we can and stop once
-    // new blocks are encountered
-    const auto& ev = m_scenar.events.at(event_id);
-    if (eventIsInSameBlock(ev))
-    {
-      events.at(event_id) = m;
-      for (const auto& cid : nextIntervals(ev, m_scenar))
-      {
-        mark(cid, m, notSame, notSure, notSameEvent);
-      }
-    }
-    else
+    if (const Mark b = elementBlock[i]; b != NoMark)
     {
-      notSameEvent.insert(event_id);
+      disp.submit(new Scenario::Command::ChangeElementLabel<T>{
+          *elements[i], Metrics::Cyclomatic::BlockLabel(blocks, b)});
     }
   }
+}
 
-  void mark(
-      const Id<Scenario::IntervalModel>& id,
-      Mark m,
-      std::set<Id<Scenario::TimeSyncModel>>& notSame,
-      std::set<Id<Scenario::TimeSyncModel>>& notSure,
-      std::set<Id<Scenario::EventModel>>& notSameEvent)
-  {
-    const auto& cst = m_scenar.intervals.at(id);
-    intervals.at(id) = m;
-
-    const auto& endNode = endTimeSync(cst, m_scenar);
-    auto sameblock = timeSyncIsInSameBlock(endNode, m);
-    switch (sameblock)
-    {
-      case NodeInBlock::Same:
-        mark(endNode.id(), m, notSame, notSure, notSameEvent);
-        break;
-      case NodeInBlock::NotSure:
-        notSure.insert(endNode.id());
-        break;
-      case NodeInBlock::NotSame:
-        notSame.insert(endNode.id());
-        break;
-    }
-  }
-};
+void stal::Metrics::Cyclomatic::ApplyLabels(
+    const ScenarioGraph& scenar,
+    const BlockGraph& blocks,
+    const score::CommandStackFacade& stack)
+{
+  MacroCommandDispatcher<LabelBlocks> disp{stack};
+  submitLabels(disp, scenar.intervals, blocks.intervalBlock, blocks);
+  submitLabels(disp, scenar.events, blocks.eventBlock, blocks);
+  submitLabels(disp, scenar.timeSyncs, blocks.timeSyncBlock, blocks);
+  disp.commit();
+}
 
 stal::Metrics::Cyclomatic::Factors
 stal::Metrics::Cyclomatic::ComputeFactors(const Scenario::ProcessModel& scenar)
+{
+  return ComputeFactors(ScenarioGraph{scenar, false});
+}
+
+stal::Metrics::Cyclomatic::Factors
+stal::Metrics::Cyclomatic::ComputeFactors(const ScenarioGraph& scenar)
 {
   ProgramVisitor v(scenar);
   auto programs = v.programs();
@@ -1337,71 +1335,19 @@ stal::Metrics::Cyclomatic::ComputeFactors(const Scenario::ProcessModel& scenar)
 stal::Metrics::Cyclomatic::Factors stal::Metrics::Cyclomatic::ComputeFactors2(
     const Scenario::ProcessModel& scenar)
 {
-  ProgramVisitor v(scenar);
-  auto programs = v.programs();
+  return ComputeFactors2(ScenarioGraph{scenar, false});
+}
 
+stal::Metrics::Cyclomatic::Factors
+stal::Metrics::Cyclomatic::ComputeFactors2(const ScenarioGraph& scenar)
+{
   // Second case, more intelligent.
-  int program_n = 0;
-  int E = 0;
-  int N = 0;
-  int P = std::ssize(programs);
-  for (const auto& program : programs)
-  {
-    CyclomaticVisitor vis2(program, scenar);
-    auto blocks = vis2.blocks();
-
-    for (auto i = 0U; i < blocks.size(); i++)
-    {
-      const auto& block = blocks[i];
-      N += 1;
-      std::set<int> nextBlocks;
-      // We search all the adjacent forward blocks and we add edges.
-
-      for (const auto& elt_id : block.intervals)
-      {
-        auto& elt = scenar.intervals.at(elt_id);
-        elt.metadata().setLabel(
-            QString::number(program_n) + " - " + QString::number(i));
-
-        auto& tn = endTimeSync(elt, scenar);
-        auto it = ossia::find_if(blocks, [&](const BaseBlock& block) {
-          return ossia::contains(block.nodes, tn.id());
-        });
-        if (it != blocks.end())
-        {
-          nextBlocks.insert(it->block && it->block != block.block);
-        }
-      }
-      for (const auto& elt_id : block.events)
-      {
-        auto& elt = scenar.events.at(elt_id);
-        elt.metadata().setLabel(
-            QString::number(program_n) + " - " + QString::number(i));
-      }
-      for (const auto& elt_id : block.nodes)
-      {
-        auto& elt = scenar.timeSyncs.at(elt_id);
-        elt.metadata().setLabel(
-            QString::number(program_n) + " - " + QString::number(i));
-
-        for (const auto& event : elt.events())
-        {
-          auto it = ossia::find_if(blocks, [&](const BaseBlock& block) {
-            return ossia::contains(block.events, event);
-          });
-          if (it != blocks.end() && it->block != block.block)
-          {
-            nextBlocks.insert(it->block);
-            nextBlocks.insert(-it->block); // Twice for the disabled part
-          }
-        }
-      }
-
-      E += nextBlocks.size();
-    }
-    program_n++;
-  }
+  return ComputeFactors2(ComputeBlocks(scenar));
+}
 
+stal::Metrics::Cyclomatic::Factors
+stal::Metrics::Cyclomatic::ComputeFactors2(const BlockGraph& blocks)
+{
   // To compute the metric, we create the graph between blocks.
   // For each block, if it is adjacent to another block,
   // we add an edge between them.
@@ -1409,7 +1355,9 @@ stal::Metrics::Cyclomatic::Factors stal::Metrics::Cyclomatic::ComputeFactors2(
   // case). If it begins with a trigger,
   //  - if the range is infinite :
   //  - else it does not change.
-
-  return stal::Metrics::Cyclomatic::Factors{E, N, P};
+  return stal::Metrics::Cyclomatic::Factors{
+      (int)blocks.successorEdges.size(),
+      (int)blocks.blockCount(),
+      (int)blocks.programCount()};
 }
 }
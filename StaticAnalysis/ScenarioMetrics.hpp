@@ -1,14 +1,23 @@
 #pragma once
 #include <QString>
 
+#include <array>
 #include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
 
 namespace Scenario
 {
 class ProcessModel;
 }
+namespace score
+{
+class CommandStackFacade;
+}
 namespace stal
 {
+struct ScenarioGraph;
 namespace Metrics
 {
 namespace Halstead
@@ -20,7 +29,30 @@ struct Factors
   double N1{};
   double N2{};
 };
+/**
+ * @brief Occurrence counts from which the factors are computed.
+ *
+ * Operands are local to their scenario : the counts of different scenarios
+ * of a hierarchy can be summed.
+ */
+struct Counts
+{
+  std::array<int, 11> operators{};
+  int uniqueVariables{};
+  int variables{};
+  int expressions{};
+  int intervalRigidTimes{};
+  int intervalMinMaxTimes{};
+
+  Counts& operator+=(const Counts& other) noexcept;
+};
+
+//! Sub-scenarios are counted if the graph was built recursively.
+Counts ComputeCounts(const ScenarioGraph& scenar);
+
 Factors ComputeFactors(const Scenario::ProcessModel& scenar);
+Factors ComputeFactors(const ScenarioGraph& scenar);
+Factors ComputeFactors(const Counts& counts);
 inline double ProgramLength(const Factors& f)
 {
   return f.eta1 * std::log2(f.eta1) + f.eta2 * std::log2(f.eta2);
@@ -64,8 +96,67 @@ struct Factors
   int connectedComponents{};
 };
 
+/**
+ * @brief Basic blocks of a scenario and the control flow between them.
+ *
+ * Blocks are numbered contiguously program by program. The element tables
+ * are indexed like the ScenarioGraph they were computed from.
+ */
+struct BlockGraph
+{
+  static constexpr int32_t none = -1;
+
+  enum class EdgeKind : uint8_t
+  {
+    Enabled,
+    Disabled // The event condition was false
+  };
+  struct Edge
+  {
+    int32_t block{};
+    EdgeKind kind{};
+  };
+
+  // Block of each element, none if the element is in no program.
+  std::vector<int32_t> intervalBlock;
+  std::vector<int32_t> eventBlock;
+  std::vector<int32_t> timeSyncBlock;
+
+  std::vector<int32_t> blockProgram;
+  std::vector<uint32_t> programBlocks{0}; // First block of each program
+
+  // Successors of each block, each (block, kind) pair at most once.
+  std::vector<uint32_t> successorOffsets{0};
+  std::vector<Edge> successorEdges;
+
+  std::size_t blockCount() const noexcept { return blockProgram.size(); }
+  std::size_t programCount() const noexcept
+  {
+    return programBlocks.size() - 1;
+  }
+  std::span<const Edge> successors(int32_t block) const noexcept
+  {
+    return {successorEdges.data() + successorOffsets[block],
+            successorEdges.data() + successorOffsets[block + 1]};
+  }
+};
+
+BlockGraph ComputeBlocks(const ScenarioGraph& scenar);
+
+//! "program - block", with the block numbered inside its program.
+QString BlockLabel(const BlockGraph& blocks, int32_t block);
+
+//! Writes the block labels on the elements, as a single undoable command.
+void ApplyLabels(
+    const ScenarioGraph& scenar,
+    const BlockGraph& blocks,
+    const score::CommandStackFacade& stack);
+
 Factors ComputeFactors(const Scenario::ProcessModel& scenar);
+Factors ComputeFactors(const ScenarioGraph& scenar);
 Factors ComputeFactors2(const Scenario::ProcessModel& scenar);
+Factors ComputeFactors2(const ScenarioGraph& scenar);
+Factors ComputeFactors2(const BlockGraph& blocks);
 
 inline double Complexity(const Factors& f)
 {
@@ -74,6 +165,8 @@ inline double Complexity(const Factors& f)
 }
 
 QString toScenarioLanguage(const Scenario::ProcessModel& s);
+QString toScenarioLanguage(const ScenarioGraph& s);
 QString toML(const Scenario::ProcessModel& s);
+QString toML(const ScenarioGraph& s);
 }
 }
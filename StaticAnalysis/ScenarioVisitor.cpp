@@ -22,6 +22,7 @@
 #include <score/document/DocumentInterface.hpp>
 #include <score/model/Identifier.hpp>
 #include <score/plugins/application/GUIApplicationPlugin.hpp>
+#include <score/selection/SelectionStack.hpp>
 
 #include <core/document/Document.hpp>
 
@@ -33,22 +34,60 @@
 #include <QDebug>
 #include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QJsonDocument>
 #include <QMenu>
+#include <QMessageBox>
 #include <QSaveFile>
 #include <QString>
 
 #include <StaticAnalysis/CppGenerator.hpp>
+#include <StaticAnalysis/MetricsService.hpp>
 #include <StaticAnalysis/ReactiveIS.hpp>
 #include <StaticAnalysis/ScenarioGenerator.hpp>
+#include <StaticAnalysis/ScenarioGraph.hpp>
 #include <StaticAnalysis/ScenarioMetrics.hpp>
 #include <StaticAnalysis/ScenarioVisitor.hpp>
 #include <StaticAnalysis/Statistics.hpp>
+#include <StaticAnalysis/TACache.hpp>
+#include <StaticAnalysis/TAChecker.hpp>
 #include <StaticAnalysis/TAConversion.hpp>
+#include <StaticAnalysis/TAExplorer.hpp>
+#include <StaticAnalysis/TASimulator.hpp>
 #include <StaticAnalysis/TIKZConversion.hpp>
 
 #include <sstream>
 
+namespace
+{
+// Past this many states, the checks of the menu give up rather than keep
+// the application frozen.
+constexpr std::size_t checkStateLimit = 1 << 21;
+
+QString report(
+    const QString& query,
+    const stal::TA::CheckResult& res,
+    bool interrupted)
+{
+  if (interrupted)
+    return query + " : inconclusive, interrupted after "
+           + QString::number(res.states) + " states\n\n";
+
+  QString text = query + (res.satisfied ? " : satisfied" : " : not satisfied")
+                 + " (" + QString::number(res.states) + " states)\n";
+  for (const auto& step : res.trace)
+    text += "  " + QString::fromStdString(step) + "\n";
+  return text + "\n";
+}
+
+QString report(const QString& query, const stal::TA::Estimate& res)
+{
+  return query + " : " + QString::number(res.probability) + " in ["
+         + QString::number(res.low) + ", " + QString::number(res.high)
+         + "] (" + QString::number(res.successes) + " runs)\n\n";
+}
+}
+
 stal::ApplicationPlugin::ApplicationPlugin(const score::GUIApplicationContext& app)
     : score::GUIApplicationPlugin{app}
 {
@@ -139,22 +178,159 @@ stal::ApplicationPlugin::ApplicationPlugin(const score::GUIApplicationContext& a
         */
     stal::generateScenario(*firstScenario, 300, disp);
   });
+  auto convert = [&](const TA::ExportOptions& options) {
+    auto doc = currentDocument();
+    if(!doc)
+      return;
+    Scenario::ScenarioDocumentModel& base
+        = score::IDocument::get<Scenario::ScenarioDocumentModel>(*doc);
+
+    QFile f("model-output.xml");
+    if (!f.open(QFile::ReadWrite | QFile::Truncate))
+      return;
+    if (!m_taCache)
+      m_taCache = std::make_unique<TA::FragmentCache>();
+    TA::ExportOptions cached = options;
+    cached.cache = m_taCache.get();
+    if (!TA::makeScenario(base.baseScenario().interval(), f, cached))
+    {
+      QMessageBox::warning(
+          qApp->activeWindow(),
+          tr("Temporal Automata export"),
+          tr("Could not write %1: %2").arg(f.fileName(), f.errorString()));
+      return;
+    }
+
+    // Only the beginning is shown : a large model is not read back whole.
+    constexpr qint64 previewSize = 64 * 1024;
+    QString text = tr("Written to %1 (%2 bytes)")
+                       .arg(QFileInfo{f}.absoluteFilePath())
+                       .arg(f.size());
+    if (f.size() > previewSize)
+      text += tr(", first %1 KB below").arg(previewSize / 1024);
+    f.seek(0);
+    text += "\n\n" + QString::fromUtf8(f.read(previewSize));
+
+    Scenario::TextDialog dial(text, qApp->activeWindow());
+    dial.exec();
+  };
+
   m_convert = new QAction{tr("Convert to Temporal Automatas"), nullptr};
-  connect(m_convert, &QAction::triggered, [&]() {
+  connect(m_convert, &QAction::triggered, [=]() { convert({}); });
+
+  m_convertReduced
+      = new QAction{tr("Convert to reduced Temporal Automatas"), nullptr};
+  connect(m_convertReduced, &QAction::triggered, [=]() {
+    TA::ExportOptions options;
+    options.reduce = true;
+    convert(options);
+  });
+
+  m_convertComposed = new QAction{
+      tr("Convert to compositional Temporal Automatas"), nullptr};
+  connect(m_convertComposed, &QAction::triggered, [=]() {
+    TA::ExportOptions options;
+    options.compose = true;
+    convert(options);
+  });
+
+  m_convertArrays = new QAction{
+      tr("Convert to Temporal Automatas with parameter arrays"), nullptr};
+  connect(m_convertArrays, &QAction::triggered, [=]() {
+    TA::ExportOptions options;
+    options.arrays = true;
+    convert(options);
+  });
+
+  m_convertSliced = new QAction{
+      tr("Convert the selection to sliced Temporal Automatas"), nullptr};
+  connect(m_convertSliced, &QAction::triggered, [this, convert]() {
+    auto doc = currentDocument();
+    if(!doc)
+      return;
+
+    // The first selected interval or time sync
+    TA::ExportOptions options;
+    for (const auto& obj : doc->context().selectionStack.currentSelection())
+    {
+      if (qobject_cast<const Scenario::IntervalModel*>(obj.data())
+          || qobject_cast<const Scenario::TimeSyncModel*>(obj.data()))
+      {
+        options.slice = obj.data();
+        break;
+      }
+    }
+    convert(options);
+  });
+
+  m_checkTA = new QAction{tr("Check Temporal Automatas"), nullptr};
+  connect(m_checkTA, &QAction::triggered, [&]() {
     auto doc = currentDocument();
     if(!doc)
       return;
     Scenario::ScenarioDocumentModel& base
         = score::IDocument::get<Scenario::ScenarioDocumentModel>(*doc);
 
-    QString text = TA::makeScenario(base.baseScenario().interval());
+    const auto content = TA::makeContent(base.baseScenario().interval());
+    const TA::TANetwork network{content};
+    TA::TAChecker checker{network};
+    checker.setStateLimit(checkStateLimit);
+
+    QString text;
+    const auto end = checker.mainEndAlwaysHappens();
+    text += report("A<> MainEndEvent.finished", end, checker.interrupted());
+    const auto error = checker.controlErrorReachable();
+    text += report("E<> Control.error", error, checker.interrupted());
+
     Scenario::TextDialog dial(text, qApp->activeWindow());
     dial.exec();
+  });
 
-    QFile f("model-output.xml");
-    f.open(QFile::WriteOnly);
-    f.write(text.toUtf8());
-    f.close();
+  m_exploreTA
+      = new QAction{tr("Explore Temporal Automatas in discrete time"), nullptr};
+  connect(m_exploreTA, &QAction::triggered, [&]() {
+    auto doc = currentDocument();
+    if(!doc)
+      return;
+    Scenario::ScenarioDocumentModel& base
+        = score::IDocument::get<Scenario::ScenarioDocumentModel>(*doc);
+
+    const auto content = TA::makeContent(base.baseScenario().interval());
+    const TA::TANetwork network{content};
+    TA::TAExplorer explorer{network};
+    explorer.setStateLimit(checkStateLimit);
+
+    QString text = "Tick : " + QString::number(explorer.tick()) + " ms\n\n";
+    const auto end = explorer.mainEndAlwaysHappens();
+    text += report("A<> MainEndEvent.finished", end, explorer.interrupted());
+    const auto error = explorer.controlErrorReachable();
+    text += report("E<> Control.error", error, explorer.interrupted());
+
+    Scenario::TextDialog dial(text, qApp->activeWindow());
+    dial.exec();
+  });
+
+  m_simulateTA = new QAction{tr("Simulate Temporal Automatas"), nullptr};
+  connect(m_simulateTA, &QAction::triggered, [&]() {
+    auto doc = currentDocument();
+    if(!doc)
+      return;
+    Scenario::ScenarioDocumentModel& base
+        = score::IDocument::get<Scenario::ScenarioDocumentModel>(*doc);
+
+    const auto content = TA::makeContent(base.baseScenario().interval());
+    const TA::TANetwork network{content};
+    const TA::SimulationOptions options;
+    const auto res = TA::TASimulator{network}.simulate(options);
+
+    QString text = QString::number(res.runs) + " runs, confidence "
+                   + QString::number(options.confidence) + "\n\n";
+    text += report("Pr[<> MainEndEvent.finished]", res.mainEnd);
+    text += report("Pr[<> Control.error]", res.controlError);
+    text += "Mean end date : " + QString::number(res.meanEndDate) + " ms\n";
+
+    Scenario::TextDialog dial(text, qApp->activeWindow());
+    dial.exec();
   });
 
   m_metrics = new QAction{tr("Scenario metrics"), nullptr};
@@ -170,11 +346,16 @@ stal::ApplicationPlugin::ApplicationPlugin(const score::GUIApplicationContext& a
 
     using namespace stal::Metrics;
     // Language
-    QString str = toScenarioLanguage(baseScenario);
+    QString str = toScenarioLanguage(stal::ScenarioGraph{baseScenario});
+
+    // The factors are only recomputed for the scenarios edited since the
+    // last time.
+    if(!m_metricsService)
+      m_metricsService = std::make_unique<stal::MetricsService>(baseScenario);
 
     // Halstead
     {
-      auto factors = Halstead::ComputeFactors(baseScenario);
+      auto factors = m_metricsService->halstead();
       str += "Difficulty = " + QString::number(Halstead::Difficulty(factors)) + "\n";
       str += "Volume = " + QString::number(Halstead::Volume(factors)) + "\n";
       str += "Effort = " + QString::number(Halstead::Effort(factors)) + "\n";
@@ -183,14 +364,33 @@ stal::ApplicationPlugin::ApplicationPlugin(const score::GUIApplicationContext& a
     }
     // Cyclomatic
     {
-      auto factors = Cyclomatic::ComputeFactors(baseScenario);
-      str += "Cyclomatic1 = " + QString::number(Cyclomatic::Complexity(factors));
+      auto factors = m_metricsService->cyclomatic();
+      str += "Cyclomatic1 = " + QString::number(Cyclomatic::Complexity(factors)) + "\n";
+      auto factors2 = m_metricsService->cyclomatic2();
+      str += "Cyclomatic2 = " + QString::number(Cyclomatic::Complexity(factors2));
     }
     // Display
     Scenario::TextDialog dial(str, qApp->activeWindow());
     dial.exec();
   });
 
+  m_labelBlocks = new QAction{tr("Label cyclomatic blocks"), nullptr};
+  connect(m_labelBlocks, &QAction::triggered, [&]() {
+    auto doc = currentDocument();
+    if(!doc)
+      return;
+
+    Scenario::ScenarioDocumentModel& base
+        = score::IDocument::get<Scenario::ScenarioDocumentModel>(*doc);
+    auto& baseScenario = static_cast<Scenario::ProcessModel&>(
+        *base.baseScenario().interval().processes.begin());
+
+    using namespace stal::Metrics;
+    const stal::ScenarioGraph graph{baseScenario, false};
+    const auto blocks = Cyclomatic::ComputeBlocks(graph);
+    Cyclomatic::ApplyLabels(graph, blocks, doc->context().commandStack);
+  });
+
   m_TIKZexport = new QAction{tr("Export in TIKZ"), nullptr};
   connect(m_TIKZexport, &QAction::triggered, [&]() {
     auto doc = currentDocument();
@@ -350,6 +550,16 @@ stal::ApplicationPlugin::ApplicationPlugin(const score::GUIApplicationContext& a
   });
 }
 
+stal::ApplicationPlugin::~ApplicationPlugin() = default;
+
+void stal::ApplicationPlugin::on_documentChanged(
+    score::Document* olddoc,
+    score::Document* newdoc)
+{
+  m_metricsService.reset();
+  m_taCache.reset();
+}
+
 score::GUIElements stal::ApplicationPlugin::makeGUIElements()
 {
   auto& m = context.menus.get().at(score::Menus::Export());
@@ -361,7 +571,15 @@ score::GUIElements stal::ApplicationPlugin::makeGUIElements()
   menu->addAction(m_carlito);
   menu->addAction(m_generate);
   menu->addAction(m_convert);
+  menu->addAction(m_convertReduced);
+  menu->addAction(m_convertComposed);
+  menu->addAction(m_convertArrays);
+  menu->addAction(m_convertSliced);
+  menu->addAction(m_checkTA);
+  menu->addAction(m_exploreTA);
+  menu->addAction(m_simulateTA);
   menu->addAction(m_metrics);
+  menu->addAction(m_labelBlocks);
   menu->addAction(m_TIKZexport);
   menu->addAction(m_statistics);
 
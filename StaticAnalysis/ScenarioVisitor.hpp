@@ -1,6 +1,8 @@
 #pragma once
 #include <score/plugins/application/GUIApplicationPlugin.hpp>
 
+#include <memory>
+
 class QAction;
 namespace score
 {
@@ -10,22 +12,44 @@ class MenubarManager;
 // RENAMEME
 namespace stal
 {
+class MetricsService;
+namespace TA
+{
+class FragmentCache;
+}
 class ApplicationPlugin : public QObject, public score::GUIApplicationPlugin
 {
 public:
   ApplicationPlugin(const score::GUIApplicationContext& app);
+  ~ApplicationPlugin() override;
 
 private:
   score::GUIElements makeGUIElements() override;
+  void on_documentChanged(
+      score::Document* olddoc,
+      score::Document* newdoc) override;
 
   QAction* m_himito{};
   QAction* m_carlito{};
   QAction* m_generate{};
   QAction* m_convert{};
+  QAction* m_convertReduced{};
+  QAction* m_convertComposed{};
+  QAction* m_convertArrays{};
+  QAction* m_convertSliced{};
+  QAction* m_checkTA{};
+  QAction* m_exploreTA{};
+  QAction* m_simulateTA{};
   QAction* m_metrics{};
+  QAction* m_labelBlocks{};
   QAction* m_MLexport{};
   QAction* m_CPPexport{};
   QAction* m_TIKZexport{};
   QAction* m_statistics{};
+
+  // Metrics of the current document, kept up to date while it is edited
+  std::unique_ptr<MetricsService> m_metricsService;
+  // Sub-scenarios of the previous Temporal Automata exports of the document
+  std::unique_ptr<TA::FragmentCache> m_taCache;
 };
 }
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stal
+{
+//! Handle of an interned string.
+using Symbol = int32_t;
+constexpr Symbol NoSymbol = -1;
+
+/**
+ * @brief Interned strings, stored back to back in one arena.
+ *
+ * Each distinct string is stored once and named by a dense handle : equal
+ * strings get the same symbol. The index is an open-addressing hash table
+ * of symbols, with linear probing.
+ */
+class SymbolTable
+{
+public:
+  SymbolTable() { m_index.assign(64, NoSymbol); }
+
+  //! Interns the concatenation of the parts. They may be views of this
+  //! table.
+  template <typename... Parts>
+  Symbol intern(const Parts&... parts)
+  {
+    // The string is built apart, as the arena can move while it grows, and
+    // only stored if it is not there yet.
+    m_scratch.clear();
+    (m_scratch.append(parts), ...);
+    return commit(m_scratch);
+  }
+
+  std::string_view view(Symbol s) const noexcept
+  {
+    if (s == NoSymbol)
+      return {};
+    return std::string_view{m_arena}.substr(
+        m_offsets[s], m_offsets[s + 1] - m_offsets[s]);
+  }
+
+  std::size_t size() const noexcept { return m_offsets.size() - 1; }
+
+private:
+  static std::size_t hash(std::string_view str) noexcept
+  {
+    return std::hash<std::string_view>{}(str);
+  }
+
+  Symbol commit(std::string_view str)
+  {
+    const std::size_t mask = m_index.size() - 1;
+    for (std::size_t slot = hash(str) & mask;; slot = (slot + 1) & mask)
+    {
+      const Symbol s = m_index[slot];
+      if (s == NoSymbol)
+      {
+        const auto sym = Symbol(size());
+        m_arena.append(str);
+        m_offsets.push_back(uint32_t(m_arena.size()));
+        m_index[slot] = sym;
+        if (2 * size() > m_index.size())
+          rehash();
+        return sym;
+      }
+      if (view(s) == str)
+        return s;
+    }
+  }
+
+  void rehash()
+  {
+    std::vector<Symbol> index(2 * m_index.size(), NoSymbol);
+    const std::size_t mask = index.size() - 1;
+    for (Symbol s = 0; s < Symbol(size()); s++)
+    {
+      std::size_t slot = hash(view(s)) & mask;
+      while (index[slot] != NoSymbol)
+        slot = (slot + 1) & mask;
+      index[slot] = s;
+    }
+    m_index = std::move(index);
+  }
+
+  std::string m_arena;
+  std::string m_scratch;
+  std::vector<uint32_t> m_offsets{0};
+  std::vector<Symbol> m_index;
+};
+}
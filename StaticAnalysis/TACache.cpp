@@ -0,0 +1,105 @@
+#include "TACache.hpp"
+
+namespace stal
+{
+namespace TA
+{
+namespace
+{
+// Copies the automata and variables of a content, and the positions and
+// channels of its children.
+void copy(const ScenarioContent& from, ScenarioContent& to, bool contents)
+{
+  to.symbols = from.symbols;
+  to.broadcasts = from.broadcasts;
+  to.ints = from.ints;
+  to.bools = from.bools;
+  to.rigids = from.rigids;
+  to.flexibles = from.flexibles;
+  to.points = from.points;
+  to.events = from.events;
+  to.events_nd = from.events_nd;
+  to.mixs = from.mixs;
+  to.controls = from.controls;
+
+  to.children.clear();
+  for (const auto& child : from.children)
+  {
+    to.children.push_back(
+        {child.position,
+         child.event_s,
+         child.skip,
+         child.kill,
+         contents ? std::make_unique<ScenarioContent>() : nullptr});
+  }
+
+  to.name = from.name;
+  to.event_s = from.event_s;
+  to.skip = from.skip;
+  to.kill = from.kill;
+  to.key = from.key;
+}
+
+// Looks in the entries of this export, then in the ones of the previous.
+template <typename Map>
+typename Map::mapped_type
+lookup(Map& current, const Map& previous, const typename Map::key_type& key)
+{
+  if (auto it = current.find(key); it != current.end())
+    return it->second;
+  if (auto it = previous.find(key); it != previous.end())
+    return current.emplace(key, it->second).first->second;
+  return {};
+}
+}
+
+FragmentCache::Fragment::Fragment(const ScenarioContent& content)
+{
+  copy(content, this->content, false);
+}
+
+void FragmentCache::Fragment::restore(ScenarioContent& content) const
+{
+  copy(this->content, content, true);
+}
+
+void FragmentCache::nextExport()
+{
+  std::lock_guard lock{m_mutex};
+  m_previousFragments = std::move(m_fragments);
+  m_fragments.clear();
+  m_previousTexts = std::move(m_texts);
+  m_texts.clear();
+}
+
+std::shared_ptr<const FragmentCache::Fragment> FragmentCache::find(uint64_t key)
+{
+  std::lock_guard lock{m_mutex};
+  return lookup(m_fragments, m_previousFragments, key);
+}
+
+void FragmentCache::insert(
+    uint64_t key,
+    std::shared_ptr<const Fragment> fragment)
+{
+  std::lock_guard lock{m_mutex};
+  m_fragments.insert_or_assign(key, std::move(fragment));
+}
+
+std::shared_ptr<const FragmentCache::Text>
+FragmentCache::findText(uint64_t key, int64_t unit)
+{
+  std::lock_guard lock{m_mutex};
+  return lookup(m_texts, m_previousTexts, TextKey{key, unit});
+}
+
+void FragmentCache::insertText(
+    uint64_t key,
+    int64_t unit,
+    std::shared_ptr<const Text> text)
+{
+  std::lock_guard lock{m_mutex};
+  m_texts.insert_or_assign(TextKey{key, unit}, std::move(text));
+}
+}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <StaticAnalysis/TAConversion.hpp>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace stal
+{
+namespace TA
+{
+/**
+ * @brief Sub-scenarios converted by the previous exports, and their UPPAAL
+ * text.
+ *
+ * Each sub-scenario is converted into a fragment of its own. Its key hashes
+ * everything the conversion reads : the ids, durations, conditions and
+ * metadata of its elements, where its own sub-scenarios are, its name and
+ * the channels of its interval. An export only converts and prints again
+ * the sub-scenarios whose key is not here, and copies the others.
+ *
+ * The entries an export does not use are dropped by the next one.
+ */
+class FragmentCache
+{
+public:
+  //! Kinds of automata, see forEachKind.
+  static constexpr std::size_t kinds = 7;
+
+  //! A converted sub-scenario : its children have no content, their
+  //! sub-scenarios are fragments of their own.
+  struct Fragment
+  {
+    explicit Fragment(const ScenarioContent& content);
+
+    //! Replaces a content by this one, with an empty content per child.
+    void restore(ScenarioContent& content) const;
+
+    ScenarioContent content;
+  };
+
+  //! Printed automata of a fragment and their names in the system line,
+  //! joined by its separator, for each kind, cut at the positions of its
+  //! children.
+  struct Text
+  {
+    std::array<std::vector<std::string>, kinds> elements;
+    std::array<std::vector<std::string>, kinds> names;
+  };
+
+  //! Starts an export : drops the entries the previous one did not use.
+  void nextExport();
+
+  std::shared_ptr<const Fragment> find(uint64_t key);
+  void insert(uint64_t key, std::shared_ptr<const Fragment> fragment);
+
+  //! Text of a fragment with durations in the given unit.
+  std::shared_ptr<const Text> findText(uint64_t key, int64_t unit);
+  void
+  insertText(uint64_t key, int64_t unit, std::shared_ptr<const Text> text);
+
+private:
+  using TextKey = std::pair<uint64_t, int64_t>;
+
+  std::mutex m_mutex;
+  std::unordered_map<uint64_t, std::shared_ptr<const Fragment>> m_fragments;
+  std::unordered_map<uint64_t, std::shared_ptr<const Fragment>>
+      m_previousFragments;
+  std::map<TextKey, std::shared_ptr<const Text>> m_texts;
+  std::map<TextKey, std::shared_ptr<const Text>> m_previousTexts;
+};
+}
+}
@@ -0,0 +1,355 @@
+#include "TAChecker.hpp"
+
+#include <algorithm>
+#include <deque>
+
+namespace stal
+{
+namespace TA
+{
+namespace
+{
+constexpr std::size_t npos = std::size_t(-1);
+}
+
+std::size_t TAChecker::DiscreteHash::operator()(const Discrete& d) const
+    noexcept
+{
+  // FNV-1a over the locations and the variables
+  std::size_t h = 14695981039346656037ull;
+  auto mix = [&](const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++)
+      h = (h ^ bytes[i]) * 1099511628211ull;
+  };
+  mix(d.locations.data(), d.locations.size());
+  mix(d.variables.data(), d.variables.size() * sizeof(int32_t));
+  return h;
+}
+
+TAChecker::TAChecker(const TANetwork& network)
+    : m_network{network}
+{
+}
+
+bool TAChecker::committed(const Discrete& d) const noexcept
+{
+  return m_network.committed(d.locations.data());
+}
+
+bool TAChecker::urgent(const Discrete& d) const noexcept
+{
+  return m_network.urgent(d.locations.data());
+}
+
+template <typename F>
+void TAChecker::transitions(const Discrete& d, const F& f) const
+{
+  m_network.transitions(d.locations.data(), d.variables.data(), f);
+}
+
+// Index in the zone of the clock of each process, 0 if it is not in use.
+std::vector<int> TAChecker::clockIndices(const Discrete& d) const
+{
+  const auto& procs = m_network.processes();
+  std::vector<int> idx(procs.size(), 0);
+  int n = 0;
+  for (std::size_t p = 0; p < procs.size(); p++)
+    if (m_network.definition(procs[p]).locations[d.locations[p]].clock)
+      idx[p] = ++n;
+  return idx;
+}
+
+bool TAChecker::constrainInvariants(
+    const Discrete& d,
+    const std::vector<int>& idx,
+    DBM& zone) const
+{
+  const auto& procs = m_network.processes();
+  for (std::size_t p = 0; p < procs.size(); p++)
+  {
+    const auto& loc
+        = m_network.definition(procs[p]).locations[d.locations[p]];
+    if (idx[p] > 0 && loc.invariant >= 0
+        && !zone.constrain(
+            idx[p], 0, bounds::le(procs[p].bounds[loc.invariant])))
+      return false;
+  }
+  return true;
+}
+
+bool TAChecker::unboundedDelay(const Discrete& d) const noexcept
+{
+  if (committed(d) || urgent(d))
+    return false;
+
+  const auto& procs = m_network.processes();
+  for (std::size_t p = 0; p < procs.size(); p++)
+  {
+    const auto& loc
+        = m_network.definition(procs[p]).locations[d.locations[p]];
+    if (loc.clock && loc.invariant >= 0)
+      return false;
+  }
+  return true;
+}
+
+// Restricts a zone to the valuations from which the transition can be
+// taken : its clock guard, and the invariants of the locations it enters
+// for the clocks it does not reset.
+bool TAChecker::enabled(
+    const Discrete& d,
+    const std::vector<int>& idx,
+    const Participants& t,
+    DBM& zone) const
+{
+  const auto& procs = m_network.processes();
+
+  const auto [p, e] = t.front();
+  const auto& edge = m_network.definition(procs[p]).edges[e];
+  if (edge.clockGuard >= 0)
+  {
+    const int32_t k = procs[p].bounds[edge.clockGuard];
+    if (!zone.constrain(idx[p], 0, bounds::le(k))
+        || !zone.constrain(0, idx[p], bounds::le(-k)))
+      return false;
+  }
+
+  for (const auto [q, qe] : t)
+  {
+    const auto& def = m_network.definition(procs[q]);
+    const auto& target = def.locations[def.edges[qe].target];
+    if (idx[q] > 0 && target.clock && target.invariant >= 0
+        && !def.edges[qe].reset
+        && !zone.constrain(
+            idx[q], 0, bounds::le(procs[q].bounds[target.invariant])))
+      return false;
+  }
+  return true;
+}
+
+bool TAChecker::successor(
+    const Discrete& d,
+    const DBM& zone,
+    const Participants& t,
+    Discrete& next,
+    DBM& nextZone) const
+{
+  const auto& procs = m_network.processes();
+
+  // Discrete part : the sender updates first, then the receivers.
+  next = d;
+  for (const auto [q, qe] : t)
+  {
+    const auto& edge = m_network.definition(procs[q]).edges[qe];
+    next.locations[q] = edge.target;
+    m_network.update(procs[q], edge.update, next.variables.data());
+  }
+  for (const auto [q, qe] : t)
+  {
+    const auto& def = m_network.definition(procs[q]);
+    if (def.locations[def.edges[qe].target].condition
+        && next.variables[procs[q].cond] == 0)
+      return false;
+  }
+
+  const auto idx = clockIndices(d);
+  DBM guarded = zone;
+  if (!enabled(d, idx, t, guarded))
+    return false;
+
+  // Clocks which are reset, or start being used, are fresh zero clocks.
+  std::vector<bool> reset(procs.size());
+  for (const auto [q, qe] : t)
+    reset[q] = m_network.definition(procs[q]).edges[qe].reset;
+
+  const auto nextIdx = clockIndices(next);
+  std::vector<int> from;
+  std::vector<int32_t> maxConstants;
+  for (std::size_t q = 0; q < procs.size(); q++)
+  {
+    if (nextIdx[q] == 0)
+      continue;
+    from.push_back(idx[q] > 0 && !reset[q] ? idx[q] : -1);
+    maxConstants.push_back(
+        std::max(procs[q].bounds[0], procs[q].bounds[1]));
+  }
+
+  nextZone = guarded.remap(from);
+  if (!constrainInvariants(next, nextIdx, nextZone))
+    return false;
+
+  if (!committed(next) && !urgent(next))
+  {
+    nextZone.up();
+    constrainInvariants(next, nextIdx, nextZone);
+  }
+  nextZone.extrapolate(maxConstants);
+  return true;
+}
+
+// Whether some valuation of the zone can neither delay nor take a
+// transition anymore.
+bool TAChecker::deadlocked(const Discrete& d, const DBM& zone) const
+{
+  const auto idx = clockIndices(d);
+  const bool delay = !committed(d) && !urgent(d);
+
+  std::vector<DBM> rest{zone};
+  std::vector<DBM> pieces;
+  Discrete next;
+  DBM nextZone{0};
+  transitions(d, [&](const Participants& t) {
+    if (rest.empty() || !successor(d, zone, t, next, nextZone))
+      return;
+
+    DBM from = zone;
+    enabled(d, idx, t, from);
+    if (delay)
+      from.down();
+
+    pieces.clear();
+    for (const auto& r : rest)
+      for (auto& piece : r.subtract(from))
+        pieces.push_back(std::move(piece));
+    std::swap(rest, pieces);
+  });
+  return !rest.empty();
+}
+
+template <typename Target, typename Expand>
+CheckResult TAChecker::explore(const Target& target, const Expand& expand)
+{
+  m_passed.clear();
+  m_nodes.clear();
+  m_interrupted = false;
+
+  CheckResult res;
+  std::deque<std::size_t> waiting;
+  auto add = [&](Discrete&& d, DBM&& zone, std::size_t parent, int32_t p,
+                 int32_t e) {
+    auto& [state, nodes] = *m_passed.try_emplace(std::move(d)).first;
+    for (std::size_t n : nodes)
+      if (zone.includedIn(m_nodes[n].zone))
+        return;
+
+    nodes.push_back(m_nodes.size());
+    waiting.push_back(m_nodes.size());
+    m_nodes.push_back(Node{&state, std::move(zone), parent, p, e});
+  };
+
+  const auto& procs = m_network.processes();
+  Discrete init{
+      std::vector<uint8_t>(procs.size(), 0), m_network.variables()};
+  const auto idx = clockIndices(init);
+  std::vector<int32_t> maxConstants;
+  for (std::size_t p = 0; p < procs.size(); p++)
+    if (idx[p] > 0)
+      maxConstants.push_back(std::max(procs[p].bounds[0], procs[p].bounds[1]));
+
+  DBM zone{int(maxConstants.size())};
+  if (!constrainInvariants(init, idx, zone))
+    return res;
+  if (!committed(init) && !urgent(init))
+  {
+    zone.up();
+    constrainInvariants(init, idx, zone);
+  }
+  zone.extrapolate(maxConstants);
+  add(std::move(init), std::move(zone), npos, -1, -1);
+
+  Discrete next;
+  DBM nextZone{0};
+  while (!waiting.empty())
+  {
+    if (m_nodes.size() > m_stateLimit)
+    {
+      m_interrupted = true;
+      break;
+    }
+
+    const std::size_t n = waiting.front();
+    waiting.pop_front();
+
+    // Nodes may move while successors are added.
+    const Discrete& state = *m_nodes[n].state;
+    const DBM current = m_nodes[n].zone;
+    if (target(state, current))
+    {
+      res.satisfied = true;
+      res.states = m_nodes.size();
+      res.trace = trace(n);
+      return res;
+    }
+    if (!expand(state))
+      continue;
+
+    transitions(state, [&](const Participants& t) {
+      if (successor(state, current, t, next, nextZone))
+        add(std::move(next), std::move(nextZone), n, t[0].first,
+            t[0].second);
+    });
+  }
+
+  res.states = m_nodes.size();
+  return res;
+}
+
+std::vector<std::string> TAChecker::trace(std::size_t node) const
+{
+  std::vector<std::string> res;
+  for (; m_nodes[node].parent != npos; node = m_nodes[node].parent)
+    res.push_back(
+        m_network.describe(m_nodes[node].process, m_nodes[node].edge));
+  std::reverse(res.begin(), res.end());
+  return res;
+}
+
+CheckResult TAChecker::controlErrorReachable()
+{
+  const auto& procs = m_network.processes();
+  const uint8_t error
+      = TANetwork::location(TANetwork::Template::Control, "error");
+
+  return explore(
+      [&](const Discrete& d, const DBM&) {
+        for (std::size_t p = 0; p < procs.size(); p++)
+          if (procs[p].kind == TANetwork::Template::Control
+              && d.locations[p] == error)
+            return true;
+        return false;
+      },
+      [](const Discrete&) { return true; });
+}
+
+CheckResult TAChecker::mainEndAlwaysHappens()
+{
+  const int32_t end = m_network.find("MainEndEvent");
+  if (end < 0)
+    return {};
+
+  const uint8_t finished
+      = TANetwork::location(TANetwork::Template::Event, "finished");
+  auto happened
+      = [&](const Discrete& d) { return d.locations[end] == finished; };
+
+  // Runs of these templates only take finitely many transitions : a run
+  // which never reaches the end stops in a deadlock, or lets time elapse
+  // forever.
+  bool forever = false;
+  auto res = explore(
+      [&](const Discrete& d, const DBM& zone) {
+        if (happened(d))
+          return false;
+        forever = unboundedDelay(d);
+        return forever || deadlocked(d, zone);
+      },
+      [&](const Discrete& d) { return !happened(d); });
+
+  res.satisfied = !res.satisfied;
+  if (!res.satisfied)
+    res.trace.push_back(forever ? "time elapses forever" : "deadlock");
+  return res;
+}
+}
+}
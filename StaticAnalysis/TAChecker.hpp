@@ -0,0 +1,116 @@
+#pragma once
+#include <StaticAnalysis/DBM.hpp>
+#include <StaticAnalysis/TANetwork.hpp>
+
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace stal
+{
+namespace TA
+{
+//! Outcome of a query, with the path to the state which decided it.
+struct CheckResult
+{
+  bool satisfied{};
+  std::size_t states{};
+  std::vector<std::string> trace;
+};
+
+/**
+ * @brief Zone-based model checker of a TANetwork.
+ *
+ * The zone graph is explored breadth-first. A symbolic state is the
+ * locations and variables of the processes, and a DBM over the clocks in
+ * use : a clock only takes part in the zone while its process is in a
+ * location which reads it. These networks being mostly sequential, the
+ * matrices stay small. Zones are extrapolated with the largest constant of
+ * each clock, and a state is not explored again when its zone is included
+ * in the zone of an explored state with the same locations and variables.
+ *
+ * Broadcast, committed and urgent semantics follow UPPAAL.
+ */
+class TAChecker
+{
+public:
+  explicit TAChecker(const TANetwork& network);
+
+  //! E<> a Control is in its error location.
+  CheckResult controlErrorReachable();
+
+  //! A<> MainEndEvent.finished
+  CheckResult mainEndAlwaysHappens();
+
+  //! Explorations stop once they have passed this many symbolic states.
+  void setStateLimit(std::size_t limit) noexcept { m_stateLimit = limit; }
+
+  //! The last exploration stopped at the limit : its result means nothing.
+  bool interrupted() const noexcept { return m_interrupted; }
+
+private:
+  struct Discrete
+  {
+    std::vector<uint8_t> locations;
+    std::vector<int32_t> variables;
+    bool operator==(const Discrete& other) const noexcept
+    {
+      return locations == other.locations && variables == other.variables;
+    }
+  };
+  struct DiscreteHash
+  {
+    std::size_t operator()(const Discrete& d) const noexcept;
+  };
+
+  struct Node
+  {
+    const Discrete* state;
+    DBM zone;
+    std::size_t parent;
+    int32_t process;
+    int32_t edge;
+  };
+
+  using Participants = TANetwork::Participants;
+
+  template <typename F>
+  void transitions(const Discrete& d, const F& f) const;
+
+  bool committed(const Discrete& d) const noexcept;
+  bool urgent(const Discrete& d) const noexcept;
+  std::vector<int> clockIndices(const Discrete& d) const;
+  bool constrainInvariants(
+      const Discrete& d, const std::vector<int>& idx, DBM& zone) const;
+  bool unboundedDelay(const Discrete& d) const noexcept;
+
+  bool enabled(
+      const Discrete& d,
+      const std::vector<int>& idx,
+      const Participants& t,
+      DBM& zone) const;
+  bool successor(
+      const Discrete& d,
+      const DBM& zone,
+      const Participants& t,
+      Discrete& next,
+      DBM& nextZone) const;
+  bool deadlocked(const Discrete& d, const DBM& zone) const;
+
+  template <typename Target, typename Expand>
+  CheckResult explore(const Target& target, const Expand& expand);
+  std::vector<std::string> trace(std::size_t node) const;
+
+  const TANetwork& m_network;
+
+  std::unordered_map<Discrete, std::vector<std::size_t>, DiscreteHash>
+      m_passed;
+  std::vector<Node> m_nodes;
+
+  std::size_t m_stateLimit{std::numeric_limits<std::size_t>::max()};
+  bool m_interrupted{};
+};
+}
+}
@@ -0,0 +1,106 @@
+#include "TAComposition.hpp"
+
+#include "TAConversion.hpp"
+#include "TAExplorer.hpp"
+#include "TANetwork.hpp"
+#include "ThreadPool.hpp"
+
+#include <optional>
+
+namespace stal
+{
+namespace TA
+{
+namespace
+{
+// Past this many states, a sub-scenario is not worth summarizing.
+constexpr std::size_t stateLimit = 1 << 20;
+
+// Dates at which a sub-scenario is over, when it is started at date 0 by
+// an Event in place of its interval, if none of its Controls can fail.
+std::optional<DateBounds> endDates(ScenarioContent& sub)
+{
+  // Interning into the same table can move the view.
+  const std::string name{sub.symbols.view(sub.name)};
+  sub.events.emplace_back(
+      sub.symbols.intern("Start_", name),
+      sub.symbols.intern("msg_start_", name),
+      sub.event_s,
+      TimeVal::zero(),
+      1);
+  sub.ints.push_back(sub.events.back().message);
+  const TANetwork network{sub};
+  sub.events.pop_back();
+  sub.ints.pop_back();
+
+  TAExplorer explorer{network};
+  explorer.setStateLimit(stateLimit);
+  if (explorer.controlErrorReachable().satisfied || explorer.interrupted())
+    return {};
+  return explorer.intervalsEnd();
+}
+
+std::unique_ptr<ScenarioContent>
+summary(const ScenarioContent& sub, const DateBounds& end)
+{
+  auto res = std::make_unique<ScenarioContent>();
+  auto& symbols = res->symbols;
+  const std::string_view name = sub.symbols.view(sub.name);
+  res->name = symbols.intern(name);
+  res->event_s = symbols.intern(sub.symbols.view(sub.event_s));
+  res->skip = symbols.intern(sub.symbols.view(sub.skip));
+  res->kill = symbols.intern(sub.symbols.view(sub.kill));
+
+  const std::string flex_name = "Summary_" + std::string{name};
+  TA::Flexible flex{symbols.intern(flex_name)};
+  flex.dmin = TimeVal::fromMsecs(end.min);
+  flex.dmax = TimeVal::fromMsecs(end.max);
+  flex.finite = true;
+
+  flex.event_s = res->event_s;
+  flex.event_min = symbols.intern("event_e1", flex_name);
+  flex.event_i = symbols.intern("event_i", flex_name);
+  flex.event_max = symbols.intern("event_e2", flex_name);
+
+  flex.skip_p = res->skip;
+  flex.kill_p = res->kill;
+  flex.skip = symbols.intern("skip", flex_name);
+  flex.kill = symbols.intern("kill", flex_name);
+  flex.comment = symbols.intern("Summary of the sub-scenario ", name);
+
+  TA::Event_ND flex_end{symbols.intern("SummaryEnd_", name),
+                        symbols.intern("msg", flex_name),
+                        flex.event_i,
+                        flex.dmax,
+                        1};
+
+  res->flexibles.push_back(flex);
+  res->events_nd.push_back(flex_end);
+  res->broadcasts = {res->event_s,
+                     res->skip,
+                     res->kill,
+                     flex.event_min,
+                     flex.event_i,
+                     flex.event_max,
+                     flex.skip,
+                     flex.kill};
+  res->ints.push_back(flex_end.message);
+  return res;
+}
+}
+
+void compose(ScenarioContent& content)
+{
+  TaskGroup tasks;
+  for (auto& child : content.children)
+  {
+    tasks.run([&child] {
+      compose(*child.content);
+      if (const auto end = endDates(*child.content))
+        child.content = summary(*child.content, *end);
+    });
+  }
+  tasks.wait();
+}
+}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+namespace stal
+{
+namespace TA
+{
+struct ScenarioContent;
+
+/**
+ * @brief Replaces each sub-scenario whose end is bounded by a Flexible.
+ *
+ * Each sub-scenario is explored alone, started at date 0 and neither skipped
+ * nor killed, the innermost ones first and the siblings in parallel. When
+ * none of its Controls can reach their error location and all its runs
+ * finish every Rigid and Flexible between two dates, its automata are
+ * replaced by a Flexible of these bounds, started, skipped and killed by
+ * the interval which contains it, and by an Event_ND which can end it
+ * anywhere in between.
+ *
+ * Nothing outside of a sub-scenario receives on its channels, so the rest
+ * of the network behaves the same. Sub-scenarios which can fail, end late,
+ * never end or are too large to explore are kept as they are.
+ */
+void compose(ScenarioContent& content);
+}
+}
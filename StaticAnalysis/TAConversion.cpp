@@ -1,20 +1,151 @@
 #include "TAConversion.hpp"
 
+#include "TACache.hpp"
+#include "TAComposition.hpp"
+#include "TAReduction.hpp"
+
+#include "ThreadPool.hpp"
+
 #include <Scenario/Document/ScenarioDocument/ScenarioDocumentModel.hpp>
 #include <Scenario/Document/State/ItemModel/MessageItemModel.hpp>
 #include <Scenario/Process/Algorithms/Accessors.hpp>
 #include <Scenario/Process/ScenarioModel.hpp>
 
+#include <score/model/IdentifiedObjectAbstract.hpp>
+
 #include <ossia/detail/algorithms.hpp>
 #include <ossia/network/value/value_conversion.hpp>
 
-#include <QFile>
+#include <QIODevice>
+#include <QResource>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
 namespace stal
 {
 namespace TA
 {
-const int uppaal_division_factor
-    = 100; // used because uppaal numbers don't go over 32768...
+namespace
+{
+// Paths start below the document model and its child.
+bool isNamed(const QObject& obj)
+{
+  const QObject* parent = obj.parent();
+  if (!parent || obj.objectName() == "DocumentModel")
+    return false;
+  if (parent->objectName() == "DocumentModel")
+    return false;
+  return parent->parent() != nullptr;
+}
+
+std::string segment(const QObject& obj)
+{
+  auto id_obj = dynamic_cast<const IdentifiedObjectAbstract*>(&obj);
+  const std::string id = std::to_string(id_obj ? id_obj->id_val() : 0);
+  const QString& type = obj.objectName();
+
+  if (type == Metadata<ObjectKey_k, Scenario::ProcessModel>::get())
+    return "S" + id;
+  else if (type == Metadata<ObjectKey_k, Scenario::EventModel>::get())
+    return "E" + id;
+  else if (type.contains("Interval"))
+    return "C" + id;
+  else if (type == Metadata<ObjectKey_k, Scenario::TimeSyncModel>::get())
+    return "T" + id;
+
+  std::string str = type.toStdString() + id;
+  std::replace(str.begin(), str.end(), '/', '_');
+  str.erase(std::remove(str.begin(), str.end(), '.'), str.end());
+  return str;
+}
+}
+
+const std::string& NameCache::operator()(const QObject& obj)
+{
+  if (auto it = m_names.find(&obj); it != m_names.end())
+    return it->second;
+
+  std::string str;
+  if (isNamed(obj))
+  {
+    str = segment(obj);
+    const std::string& parent = (*this)(*obj.parent());
+    if (!parent.empty())
+    {
+      str += '_';
+      str += parent;
+    }
+  }
+  return m_names.emplace(&obj, std::move(str)).first->second;
+}
+
+// Largest integer constant UPPAAL accepts by default.
+constexpr int64_t uppaal_int_max = 32767;
+
+namespace
+{
+//! Durations and dates are printed as multiples of a unit, in milliseconds.
+struct TimeScale
+{
+  int64_t unit{1};
+
+  int operator()(TimeVal t) const noexcept
+  {
+    return int(int64_t(t.msec()) / unit);
+  }
+};
+
+template <typename F>
+void forEachDuration(const ScenarioContent& c, const F& f)
+{
+  for (const auto& rigid : c.rigids)
+    f(rigid.dur);
+  for (const auto& flexible : c.flexibles)
+  {
+    f(flexible.dmin);
+    if (flexible.finite)
+      f(flexible.dmax);
+  }
+  for (const auto& event : c.events)
+    f(event.date);
+  for (const auto& event : c.events_nd)
+    f(event.date);
+
+  for (const auto& child : c.children)
+    forEachDuration(*child.content, f);
+}
+
+// The unit is the GCD of all the durations and dates : clock constants
+// are as small as they can be without rounding any of them.
+TimeScale timeScale(const ScenarioContent& c)
+{
+  TimeScale scale;
+  int64_t unit = 0;
+  forEachDuration(
+      c, [&](TimeVal t) { unit = std::gcd(unit, int64_t(t.msec())); });
+  if (unit > 0)
+    scale.unit = unit;
+
+  int64_t largest = 0;
+  forEachDuration(c, [&](TimeVal t) {
+    largest = std::max(largest, std::abs(int64_t(t.msec())) / scale.unit);
+  });
+  if (largest > uppaal_int_max)
+    qWarning(
+        "UPPAAL export: a constant of %lld (in units of %lld ms) exceeds "
+        "the UPPAAL integer range",
+        (long long)largest,
+        (long long)scale.unit);
+
+  return scale;
+}
+}
 static int to_operator(ossia::expressions::comparator op)
 {
   switch (op)
@@ -55,291 +186,1043 @@ static void set_point_condition(Point& point, const State::Expression& e)
   }
 }
 
-template <typename Container, typename Stream>
-static void print(const Container& vec, Stream& s)
+template <typename Stream>
+static void print(
+    const Point& pt,
+    const SymbolTable& symbols,
+    const TimeScale&,
+    Stream& stream)
 {
-  for (const auto& elt : vec)
-  {
-    print(elt, s);
-    s << "\n";
-  }
-  s << "\n";
+  if (pt.comment != NoSymbol)
+    stream << "// " << symbols.view(pt.comment) << "\n";
+
+  stream << symbols.view(pt.name) << " = Point(" << pt.condition << ", "
+         << pt.conditionValue / uppaal_division_factor << ", "
+         << symbols.view(pt.en) << ", " << symbols.view(pt.conditionMessage)
+         << ", " << symbols.view(pt.event) << ", "
+         << (pt.urgent ? "true" : "false") << ", "
+         << symbols.view(pt.event_s) << ", " << symbols.view(pt.skip_p)
+         << ", " << symbols.view(pt.event_e) << ", "
+         << symbols.view(pt.kill_p) << ", " << symbols.view(pt.skip) << ", "
+         << symbols.view(pt.event_t) << ");\n";
 }
 
 template <typename Stream>
-static void print(const Point& pt, Stream& stream)
-{
-  QString s = QString(
-                  "%1 = Point(%2, %3, %4, %5, %6, %7, %8, %9, %10, %11, %12, "
-                  "%13);\n")
-                  .arg(pt.name)
-                  .arg(pt.condition)
-                  .arg(pt.conditionValue / uppaal_division_factor)
-                  .arg(pt.en)
-                  .arg(pt.conditionMessage)
-                  .arg(pt.event)
-                  .arg(pt.urgent ? "true" : "false")
-                  .arg(pt.event_s)
-                  .arg(pt.skip_p)
-                  .arg(pt.event_e)
-                  .arg(pt.kill_p)
-                  .arg(pt.skip)
-                  .arg(pt.event_t);
-
-  if (!pt.comment.isEmpty())
-    stream << "// " << pt.comment.toLatin1().constData() << "\n";
-
-  stream << s.toLatin1().constData();
+static void print(
+    const Mix& pt,
+    const SymbolTable& symbols,
+    const TimeScale&,
+    Stream& stream)
+{
+  stream << symbols.view(pt.name) << " = Mix(" << symbols.view(pt.event_in)
+         << ", " << symbols.view(pt.event_out) << ", "
+         << symbols.view(pt.skip_p) << ", " << symbols.view(pt.kill_p)
+         << ");\n";
 }
 
 template <typename Stream>
-static void print(const Mix& pt, Stream& stream)
+static void print(
+    const Control& pt,
+    const SymbolTable& symbols,
+    const TimeScale&,
+    Stream& stream)
 {
-  QString s = QString("%1 = Mix(%2, %3, %4, %5);\n")
-                  .arg(pt.name)
-                  .arg(pt.event_in)
-                  .arg(pt.event_out)
-                  .arg(pt.skip_p)
-                  .arg(pt.kill_p);
-
-  stream << s.toLatin1().constData();
+  stream << symbols.view(pt.name) << " = Control(" << pt.num_prev_rels
+         << ", " << symbols.view(pt.event_s1) << ", "
+         << symbols.view(pt.skip_p) << ", " << symbols.view(pt.skip) << ", "
+         << symbols.view(pt.event_e) << ", " << symbols.view(pt.kill_p)
+         << ", " << symbols.view(pt.event_s2) << ");\n";
 }
 
 template <typename Stream>
-static void print(const Control& pt, Stream& stream)
+static void print(
+    const Flexible& c,
+    const SymbolTable& symbols,
+    const TimeScale& scale,
+    Stream& stream)
 {
-  QString s = QString("%1 = Control(%2, %3, %4, %5, %6, %7, %8);\n")
-                  .arg(pt.name)
-                  .arg(pt.num_prev_rels)
-                  .arg(pt.event_s1)
-                  .arg(pt.skip_p)
-                  .arg(pt.skip)
-                  .arg(pt.event_e)
-                  .arg(pt.kill_p)
-                  .arg(pt.event_s2);
+  if (c.comment != NoSymbol)
+    stream << "// " << symbols.view(c.comment) << "\n";
+
+  stream << symbols.view(c.name) << " = Flexible(" << scale(c.dmin) << ", "
+         << (c.finite ? scale(c.dmax) : 0) << ", "
+         << (c.finite ? "true" : "false") << ", "
+         << symbols.view(c.event_s) << ", " << symbols.view(c.event_min)
+         << ", " << symbols.view(c.event_i) << ", "
+         << symbols.view(c.event_max) << ", " << symbols.view(c.skip_p)
+         << ", " << symbols.view(c.kill_p) << ", " << symbols.view(c.skip)
+         << ", " << symbols.view(c.kill) << ");\n";
+}
 
-  stream << s.toLatin1().constData();
+template <typename Stream>
+static void print(
+    const Rigid& c,
+    const SymbolTable& symbols,
+    const TimeScale& scale,
+    Stream& stream)
+{
+  if (c.comment != NoSymbol)
+    stream << "// " << symbols.view(c.comment) << "\n";
+
+  stream << symbols.view(c.name) << " = Rigid(" << scale(c.dur) << ", "
+         << symbols.view(c.event_s) << ", " << symbols.view(c.event_e1)
+         << ", " << symbols.view(c.skip_p) << ", " << symbols.view(c.kill_p)
+         << ", " << symbols.view(c.skip) << ", " << symbols.view(c.kill)
+         << ", " << symbols.view(c.event_e2) << ");\n";
 }
 
 template <typename Stream>
-static void print(const Flexible& c, Stream& stream)
-{
-  QString s
-      = QString(
-            "%1 = Flexible(%2, %3, %4, %5, %6, %7, %8, %9, %10, %11, %12);\n")
-            .arg(c.name)
-            .arg((int)c.dmin.msec() / uppaal_division_factor)
-            .arg(c.finite ? (int)c.dmax.msec() / uppaal_division_factor : 0)
-            .arg(c.finite ? "true" : "false")
-            .arg(c.event_s)
-            .arg(c.event_min)
-            .arg(c.event_i)
-            .arg(c.event_max)
-            .arg(c.skip_p)
-            .arg(c.kill_p)
-            .arg(c.skip)
-            .arg(c.kill);
-
-  if (!c.comment.isEmpty())
-    stream << "// " << c.comment.toLatin1().constData() << "\n";
-
-  stream << s.toLatin1().constData();
+static void print(
+    const Event& c,
+    const SymbolTable& symbols,
+    const TimeScale& scale,
+    Stream& stream)
+{
+  stream << symbols.view(c.name) << " = Event(" << symbols.view(c.message)
+         << ", " << symbols.view(c.event) << ", " << scale(c.date) << ", "
+         << c.val << ");\n";
 }
 
 template <typename Stream>
-static void print(const Rigid& c, Stream& stream)
+static void print(
+    const Event_ND& c,
+    const SymbolTable& symbols,
+    const TimeScale& scale,
+    Stream& stream)
+{
+  stream << symbols.view(c.name) << " = Event_ND(" << symbols.view(c.message)
+         << ", " << symbols.view(c.event) << ", " << scale(c.date) << ", "
+         << c.val << ");\n";
+}
+
+// Calls f on the automata of a kind in the order of a sequential
+// conversion : the automata of a sub-scenario come right after the ones
+// its parent had when it was added.
+template <typename T, typename F>
+static void forEach(
+    const ScenarioContent& c,
+    std::vector<T> ScenarioContent::*elements,
+    std::size_t ScenarioContent::Position::*position,
+    const F& f)
+{
+  const std::vector<T>& vec = c.*elements;
+  auto child = c.children.begin();
+  for (std::size_t i = 0;; i++)
+  {
+    for (; child != c.children.end() && child->position.*position <= i;
+         ++child)
+      forEach(*child->content, elements, position, f);
+
+    if (i == vec.size())
+      break;
+    f(c.symbols, vec[i]);
+  }
+}
+
+// Calls f for each kind of automaton, in the order they are printed.
+template <typename F>
+static void forEachKind(const F& f)
 {
-  QString s = QString("%1 = Rigid(%2, %3, %4, %5, %6, %7, %8, %9);\n")
-                  .arg(c.name)
-                  .arg((int)c.dur.msec() / uppaal_division_factor)
-                  .arg(c.event_s)
-                  .arg(c.event_e1)
-                  .arg(c.skip_p)
-                  .arg(c.kill_p)
-                  .arg(c.skip)
-                  .arg(c.kill)
-                  .arg(c.event_e2);
+  using C = ScenarioContent;
+  using P = ScenarioContent::Position;
+  f(&C::events, &P::events);
+  f(&C::events_nd, &P::events_nd);
+  f(&C::rigids, &P::rigids);
+  f(&C::flexibles, &P::flexibles);
+  f(&C::points, &P::points);
+  f(&C::mixs, &P::mixs);
+  f(&C::controls, &P::controls);
+}
+
+static void collect(
+    const ScenarioContent& c,
+    std::vector<Symbol> ScenarioContent::*vars,
+    std::vector<std::string_view>& names)
+{
+  for (Symbol var : c.*vars)
+    names.push_back(c.symbols.view(var));
+  for (const auto& child : c.children)
+    collect(*child.content, vars, names);
+}
 
-  if (!c.comment.isEmpty())
-    stream << "// " << c.comment.toLatin1().constData() << "\n";
-  stream << s.toLatin1().constData();
+// Variables are declared once each, sorted by name.
+static std::vector<std::string_view> declaredNames(
+    const ScenarioContent& c,
+    std::vector<Symbol> ScenarioContent::*vars)
+{
+  std::vector<std::string_view> names;
+  collect(c, vars, names);
+  std::sort(names.begin(), names.end());
+  names.erase(std::unique(names.begin(), names.end()), names.end());
+  return names;
 }
 
 template <typename Stream>
-static void print(const Event& c, Stream& stream)
+static void printDeclarations(
+    const ScenarioContent& c,
+    std::vector<Symbol> ScenarioContent::*vars,
+    const char* type,
+    Stream& stream)
+{
+  for (std::string_view var : declaredNames(c, vars))
+    stream << type << " " << var << ";\n";
+}
+
+UppaalWriter& UppaalWriter::operator<<(std::string_view str)
+{
+  if (m_size + str.size() > m_buffer.size())
+  {
+    flush();
+    if (str.size() > m_buffer.size())
+    {
+      write(str.data(), str.size());
+      return *this;
+    }
+  }
+
+  std::copy(str.begin(), str.end(), m_buffer.begin() + m_size);
+  m_size += str.size();
+  return *this;
+}
+
+UppaalWriter& UppaalWriter::operator<<(int value)
+{
+  char str[16];
+  const auto res = std::to_chars(std::begin(str), std::end(str), value);
+  return *this << std::string_view{str, std::size_t(res.ptr - str)};
+}
+
+void UppaalWriter::flush()
+{
+  if (m_size > 0)
+    write(m_buffer.data(), m_size);
+  m_size = 0;
+}
+
+void UppaalWriter::write(const char* data, std::size_t size)
+{
+  // Nothing more is written after a failure : the model is incomplete.
+  if (m_ok && m_device.write(data, qint64(size)) != qint64(size))
+    m_ok = false;
+}
+
+namespace
+{
+/**
+ * The template of the model, split once around its two placeholders.
+ * The views point into the resource itself when it is not compressed.
+ */
+struct UppaalTemplate
+{
+  UppaalTemplate()
+      : data{QResource{":/model-uppaal.xml.in"}.uncompressedData()}
+  {
+    SCORE_ASSERT(!data.isEmpty());
+    const std::string_view str{data.constData(), std::size_t(data.size())};
+
+    constexpr std::string_view declarations = "$DECLARATIONS";
+    constexpr std::string_view system = "$SYSTEM";
+    const auto decl_pos = str.find(declarations);
+    const auto system_pos = str.find(system, decl_pos);
+    SCORE_ASSERT(decl_pos != std::string_view::npos);
+    SCORE_ASSERT(system_pos != std::string_view::npos);
+
+    prefix = str.substr(0, decl_pos);
+    middle = str.substr(
+        decl_pos + declarations.size(),
+        system_pos - decl_pos - declarations.size());
+    suffix = str.substr(system_pos + system.size());
+  }
+
+  QByteArray data;
+  std::string_view prefix;
+  std::string_view middle;
+  std::string_view suffix;
+};
+
+const UppaalTemplate& uppaalTemplate()
+{
+  static const UppaalTemplate tpl;
+  return tpl;
+}
+}
+
+// Text of the automata of a content without the ones of its children, cut
+// where they come.
+static FragmentCache::Text
+printText(const ScenarioContent& c, const TimeScale& scale)
+{
+  FragmentCache::Text text;
+  std::size_t kind = 0;
+  forEachKind([&](auto elements, auto position) {
+    const auto& vec = c.*elements;
+    std::size_t begin = 0;
+    auto segment = [&](std::size_t end) {
+      std::ostringstream elts, names;
+      const char* sep = "";
+      for (std::size_t i = begin; i < end; i++)
+      {
+        print(vec[i], c.symbols, scale, elts);
+        elts << "\n";
+        names << sep << c.symbols.view(vec[i].name);
+        sep = ",\n";
+      }
+      text.elements[kind].push_back(std::move(elts).str());
+      text.names[kind].push_back(std::move(names).str());
+      begin = end;
+    };
+    for (const auto& child : c.children)
+      segment(child.position.*position);
+    segment(vec.size());
+    kind++;
+  });
+  return text;
+}
+
+// Text of a sub-scenario, printed only if the cache does not have it yet.
+static std::shared_ptr<const FragmentCache::Text> fragmentText(
+    const ScenarioContent& c,
+    const TimeScale& scale,
+    FragmentCache* cache)
+{
+  if (!cache || c.key == 0)
+    return nullptr;
+
+  auto text = cache->findText(c.key, scale.unit);
+  if (!text)
+  {
+    text = std::make_shared<const FragmentCache::Text>(printText(c, scale));
+    cache->insertText(c.key, scale.unit, text);
+  }
+  return text;
+}
+
+// Same order as forEach : the contents which are not in the cache are
+// printed as they go.
+template <typename T>
+static void printElements(
+    const ScenarioContent& c,
+    std::vector<T> ScenarioContent::*elements,
+    std::size_t ScenarioContent::Position::*position,
+    std::size_t kind,
+    const TimeScale& scale,
+    FragmentCache* cache,
+    UppaalWriter& output)
+{
+  const auto text = fragmentText(c, scale, cache);
+  const std::vector<T>& vec = c.*elements;
+  std::size_t begin = 0;
+  for (std::size_t i = 0;; i++)
+  {
+    const std::size_t end = i < c.children.size()
+                                ? c.children[i].position.*position
+                                : vec.size();
+    if (text)
+      output << text->elements[kind][i];
+    else
+    {
+      for (std::size_t e = begin; e < end; e++)
+      {
+        print(vec[e], c.symbols, scale, output);
+        output << "\n";
+      }
+    }
+    begin = end;
+
+    if (i == c.children.size())
+      break;
+    printElements(
+        *c.children[i].content,
+        elements,
+        position,
+        kind,
+        scale,
+        cache,
+        output);
+  }
+}
+
+template <typename T>
+static void printNames(
+    const ScenarioContent& c,
+    std::vector<T> ScenarioContent::*elements,
+    std::size_t ScenarioContent::Position::*position,
+    std::size_t kind,
+    const TimeScale& scale,
+    FragmentCache* cache,
+    UppaalWriter& output,
+    const char*& sep)
+{
+  const auto text = fragmentText(c, scale, cache);
+  const std::vector<T>& vec = c.*elements;
+  std::size_t begin = 0;
+  for (std::size_t i = 0;; i++)
+  {
+    const std::size_t end = i < c.children.size()
+                                ? c.children[i].position.*position
+                                : vec.size();
+    if (text)
+    {
+      if (!text->names[kind][i].empty())
+      {
+        output << sep << text->names[kind][i];
+        sep = ",\n";
+      }
+    }
+    else
+    {
+      for (std::size_t e = begin; e < end; e++)
+      {
+        output << sep << c.symbols.view(vec[e].name);
+        sep = ",\n";
+      }
+    }
+    begin = end;
+
+    if (i == c.children.size())
+      break;
+    printNames(
+        *c.children[i].content,
+        elements,
+        position,
+        kind,
+        scale,
+        cache,
+        output,
+        sep);
+  }
+}
+
+static void print(
+    const ScenarioContent& c,
+    UppaalWriter& output,
+    FragmentCache* cache = nullptr)
+{
+  const auto& text = uppaalTemplate();
+  const TimeScale scale = timeScale(c);
+
+  output << text.prefix;
+
+  output << "///// VARIABLES /////\n";
+  output << "// Time unit : " << int(scale.unit) << " ms\n";
+  printDeclarations(c, &ScenarioContent::broadcasts, "broadcast chan", output);
+  printDeclarations(c, &ScenarioContent::bools, "bool", output);
+  printDeclarations(c, &ScenarioContent::ints, "int", output);
+
+  output << text.middle;
+
+  output << "///// ELEMENTS /////\n";
+  std::size_t kind = 0;
+  forEachKind([&](auto elements, auto position) {
+    printElements(c, elements, position, kind++, scale, cache, output);
+    output << "\n";
+  });
+
+  output << "///// SYSTEM /////\n";
+  output << "system\n";
+  const char* sep = "";
+  kind = 0;
+  forEachKind([&](auto elements, auto position) {
+    printNames(c, elements, position, kind++, scale, cache, output, sep);
+  });
+  output << ";\n";
+
+  output << text.suffix;
+}
+
+namespace
 {
-  QString s = QString("%1 = Event(%2, %3, %4, %5);\n")
-                  .arg(c.name)
-                  .arg(c.message)
-                  .arg(c.event)
-                  .arg((int)c.date.msec() / uppaal_division_factor)
-                  .arg(c.val);
+// How a template parameter is passed, see model-uppaal.xml.in.
+enum class Parameter : uint8_t
+{
+  Int,
+  Bool,
+  Channel,
+  BoolVariable,
+  IntVariable
+};
+
+// Calls f with the name, kind and value of each parameter of a template, in
+// order : the channels and variables are given by their symbol.
+template <typename F>
+void parameters(const Event& c, const TimeScale& scale, const F& f)
+{
+  f("msg", Parameter::IntVariable, c.message);
+  f("event", Parameter::Channel, c.event);
+  f("date", Parameter::Int, scale(c.date));
+  f("val", Parameter::Int, c.val);
+}
 
-  stream << s.toLatin1().constData();
+template <typename F>
+void parameters(const Event_ND& c, const TimeScale& scale, const F& f)
+{
+  f("msg", Parameter::IntVariable, c.message);
+  f("event", Parameter::Channel, c.event);
+  f("date", Parameter::Int, scale(c.date));
+  f("val", Parameter::Int, c.val);
 }
 
+template <typename F>
+void parameters(const Rigid& c, const TimeScale& scale, const F& f)
+{
+  f("dur", Parameter::Int, scale(c.dur));
+  f("event_s", Parameter::Channel, c.event_s);
+  f("event_e1", Parameter::Channel, c.event_e1);
+  f("skip_p", Parameter::Channel, c.skip_p);
+  f("kill_p", Parameter::Channel, c.kill_p);
+  f("skip", Parameter::Channel, c.skip);
+  f("kill", Parameter::Channel, c.kill);
+  f("event_e2", Parameter::Channel, c.event_e2);
+}
+
+template <typename F>
+void parameters(const Flexible& c, const TimeScale& scale, const F& f)
+{
+  f("dmin", Parameter::Int, scale(c.dmin));
+  f("dmax", Parameter::Int, c.finite ? scale(c.dmax) : 0);
+  f("finite", Parameter::Bool, c.finite);
+  f("event_s", Parameter::Channel, c.event_s);
+  f("event_e1", Parameter::Channel, c.event_min);
+  f("event_i", Parameter::Channel, c.event_i);
+  f("event_e2", Parameter::Channel, c.event_max);
+  f("skip_p", Parameter::Channel, c.skip_p);
+  f("kill_p", Parameter::Channel, c.kill_p);
+  f("skip", Parameter::Channel, c.skip);
+  f("kill", Parameter::Channel, c.kill);
+}
+
+template <typename F>
+void parameters(const Point& c, const TimeScale&, const F& f)
+{
+  f("id", Parameter::Int, c.condition);
+  f("value", Parameter::Int, c.conditionValue / uppaal_division_factor);
+  f("en", Parameter::BoolVariable, c.en);
+  f("msg", Parameter::IntVariable, c.conditionMessage);
+  f("event", Parameter::Channel, c.event);
+  f("urg", Parameter::Bool, c.urgent);
+  f("event_s", Parameter::Channel, c.event_s);
+  f("skip_p", Parameter::Channel, c.skip_p);
+  f("event_e", Parameter::Channel, c.event_e);
+  f("kill_p", Parameter::Channel, c.kill_p);
+  f("skip", Parameter::Channel, c.skip);
+  f("event_t", Parameter::Channel, c.event_t);
+}
+
+template <typename F>
+void parameters(const Mix& c, const TimeScale&, const F& f)
+{
+  f("event_in", Parameter::Channel, c.event_in);
+  f("event_out", Parameter::Channel, c.event_out);
+  f("skip_p", Parameter::Channel, c.skip_p);
+  f("kill_p", Parameter::Channel, c.kill_p);
+}
+
+template <typename F>
+void parameters(const Control& c, const TimeScale&, const F& f)
+{
+  f("n", Parameter::Int, c.num_prev_rels);
+  f("event_s1", Parameter::Channel, c.event_s1);
+  f("skip_p", Parameter::Channel, c.skip_p);
+  f("skip", Parameter::Channel, c.skip);
+  f("event_e", Parameter::Channel, c.event_e);
+  f("kill_p", Parameter::Channel, c.kill_p);
+  f("event_s2", Parameter::Channel, c.event_s2);
+}
+
+const char* templateName(const Event&) { return "Event"; }
+const char* templateName(const Event_ND&) { return "Event_ND"; }
+const char* templateName(const Rigid&) { return "Rigid"; }
+const char* templateName(const Flexible&) { return "Flexible"; }
+const char* templateName(const Point&) { return "Point"; }
+const char* templateName(const Mix&) { return "Mix"; }
+const char* templateName(const Control&) { return "Control"; }
+
+// The arrays which hold the channels and the variables.
+const char* arrayName(Parameter kind)
+{
+  switch (kind)
+  {
+    case Parameter::Channel:
+      return "channels";
+    case Parameter::BoolVariable:
+      return "bools";
+    case Parameter::IntVariable:
+      return "ints";
+    default:
+      return nullptr;
+  }
+}
+
+// One parameter of all the automata of a template.
+struct Column
+{
+  const char* name;
+  Parameter kind;
+  std::vector<int> values;
+
+  bool constant() const noexcept
+  {
+    return std::adjacent_find(
+               values.begin(), values.end(), std::not_equal_to<>{})
+           == values.end();
+  }
+};
+
 template <typename Stream>
-static void print(const Event_ND& c, Stream& stream)
+void printValue(const Column& column, int value, Stream& stream)
 {
-  QString s = QString("%1 = Event_ND(%2, %3, %4, %5);\n")
-                  .arg(c.name)
-                  .arg(c.message)
-                  .arg(c.event)
-                  .arg((int)c.date.msec() / uppaal_division_factor)
-                  .arg(c.val);
+  if (column.kind == Parameter::Bool)
+    stream << (value ? "true" : "false");
+  else
+    stream << value;
+}
 
-  stream << s.toLatin1().constData();
+template <typename Stream>
+void printArrayDeclaration(
+    const char* type,
+    Parameter kind,
+    std::size_t size,
+    Stream& stream)
+{
+  if (size > 0)
+    stream << type << " " << arrayName(kind) << "[" << int(size) << "];\n";
+}
 }
 
-static QString print(const ScenarioContent& c)
+/**
+ * Writes the model with one array per type of variable, and one
+ * instantiation of each template over the indices of its automata, whose
+ * parameters are read from constant tables. A parameter equal for all the
+ * automata of a template is written as is.
+ *
+ * Automata are numbered in the same order as in print. The elements of the
+ * root interval are listed in a comment, so that queries can name them.
+ */
+static void printArrays(const ScenarioContent& c, UppaalWriter& output)
 {
-  QFile f(":/model-uppaal.xml.in");
-  SCORE_ASSERT(f.exists());
-  f.open(QFile::ReadOnly);
-  QString str = f.readAll();
+  const auto& text = uppaalTemplate();
+  const TimeScale scale = timeScale(c);
+  const auto channels = declaredNames(c, &ScenarioContent::broadcasts);
+  const auto bools = declaredNames(c, &ScenarioContent::bools);
+  const auto ints = declaredNames(c, &ScenarioContent::ints);
+
+  auto index = [&](Parameter kind, std::string_view name) {
+    const auto& names = kind == Parameter::Channel        ? channels
+                        : kind == Parameter::BoolVariable ? bools
+                                                          : ints;
+    const auto it = std::lower_bound(names.begin(), names.end(), name);
+    SCORE_ASSERT(it != names.end() && *it == name);
+    return int(it - names.begin());
+  };
+
+  output << text.prefix;
+
+  output << "///// VARIABLES /////\n";
+  output << "// Time unit : " << int(scale.unit) << " ms\n";
+  printArrayDeclaration(
+      "broadcast chan", Parameter::Channel, channels.size(), output);
+  printArrayDeclaration("bool", Parameter::BoolVariable, bools.size(), output);
+  printArrayDeclaration("int", Parameter::IntVariable, ints.size(), output);
+
+  output << text.middle;
+
+  output << "///// ELEMENTS /////\n";
+  std::vector<std::string> processes;
+  std::vector<Column> columns;
+  forEachKind([&](auto elements, auto position) {
+    const char* name{};
+    int count = 0;
+    columns.clear();
+    forEach(c, elements, position, [&](const auto& symbols, const auto& elt) {
+      name = templateName(elt);
+      if (&symbols == &c.symbols)
+        output << "// " << name << "s(" << count
+               << ") : " << symbols.view(elt.name) << "\n";
+
+      std::size_t j = 0;
+      parameters(elt, scale, [&](const char* param, Parameter kind, int v) {
+        if (j == columns.size())
+          columns.push_back({param, kind, {}});
+        columns[j++].values.push_back(
+            arrayName(kind) ? index(kind, symbols.view(v)) : v);
+      });
+      count++;
+    });
+    if (count == 0)
+      return;
+
+    for (const auto& column : columns)
+    {
+      if (column.constant())
+        continue;
+
+      const auto [lo, hi]
+          = std::minmax_element(column.values.begin(), column.values.end());
+      output << "const ";
+      if (column.kind == Parameter::Bool)
+        output << "bool";
+      else if (*lo < -uppaal_int_max - 1 || *hi > uppaal_int_max)
+        output << "int[" << *lo << "," << *hi << "]";
+      else
+        output << "int";
+      output << " " << name << "_" << column.name << "[" << count
+             << "] = {";
+      const char* sep = "";
+      for (int v : column.values)
+      {
+        output << sep;
+        printValue(column, v, output);
+        sep = ",";
+      }
+      output << "};\n";
+    }
 
+    const std::string process = std::string{name} + "s";
+    output << process << "(const int[0," << (count - 1) << "] i) = " << name
+           << "(";
+    const char* sep = "";
+    for (const auto& column : columns)
+    {
+      output << sep;
+      sep = ", ";
+
+      const char* array = arrayName(column.kind);
+      if (array)
+        output << array << "[";
+      if (column.constant())
+        printValue(column, column.values.front(), output);
+      else
+        output << name << "_" << column.name << "[i]";
+      if (array)
+        output << "]";
+    }
+    output << ");\n\n";
+    processes.push_back(process);
+  });
+
+  output << "///// SYSTEM /////\n";
+  output << "system ";
+  const char* sep = "";
+  for (const auto& process : processes)
   {
-    std::stringstream output;
+    output << sep << process;
+    sep = ", ";
+  }
+  output << ";\n";
 
-    output << "///// VARIABLES /////\n";
-    for (const auto& elt : c.broadcasts)
-      output << "broadcast chan " << qUtf8Printable(elt) << ";\n";
-    for (const auto& elt : c.bools)
-      output << "bool " << qUtf8Printable(elt) << ";\n";
-    for (const auto& elt : c.ints)
-      output << "int " << qUtf8Printable(elt) << ";\n";
+  output << text.suffix;
+}
 
-    str.replace("$DECLARATIONS", QString::fromStdString(output.str()));
+namespace
+{
+// FNV-1a over the bytes of the values.
+class StructuralHash
+{
+public:
+  void add(const void* data, std::size_t size) noexcept
+  {
+    const auto bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++)
+      m_hash = (m_hash ^ bytes[i]) * 0x100000001B3ull;
+  }
+
+  template <typename T>
+  requires std::is_arithmetic_v<T> void add(T value) noexcept
+  {
+    add(&value, sizeof(value));
   }
+  void add(std::string_view str) noexcept
   {
-    std::stringstream output;
-    output << "///// ELEMENTS /////\n";
-    print(c.events, output);
-    print(c.events_nd, output);
-    print(c.rigids, output);
-    print(c.flexibles, output);
-    print(c.points, output);
-    print(c.mixs, output);
-    print(c.controls, output);
+    add(str.size());
+    add(str.data(), str.size());
+  }
+  void add(const QString& str) noexcept
+  {
+    add(std::size_t(str.size()));
+    add(str.data(), std::size_t(str.size()) * sizeof(*str.data()));
+  }
+  void add(TimeVal t) noexcept { add(t.msec()); }
 
-    output << "///// SYSTEM /////\n";
-    output << "system\n";
-    [&] (auto&&... tpl) {
-        auto f = [&](const auto& vec) {
-          for (const auto& elt : vec)
-            output << qUtf8Printable(elt.name) << ",\n";
-        };
-       (f(tpl), ...);
-    }(c.events, c.events_nd, c.rigids, c.flexibles, c.points, c.mixs, c.controls);
-    auto lastStr = QString::fromStdString(output.str());
-    lastStr[lastStr.size() - 2] = ';';
+  //! Never 0, which is no key.
+  uint64_t value() const noexcept { return m_hash != 0 ? m_hash : 1; }
 
-    str.replace("$SYSTEM", lastStr);
+private:
+  uint64_t m_hash{0xCBF29CE484222325ull};
+};
+}
+
+// Everything the conversion of a sub-scenario reads, see TAVisitor. Its
+// own sub-scenarios are fragments of their own : only where they are
+// matters.
+static uint64_t fragmentKey(
+    const Scenario::ProcessModel& s,
+    std::string_view name,
+    const TAScenario::ParentInterval& parent)
+{
+  using namespace Scenario;
+  StructuralHash h;
+  h.add(name);
+  h.add(std::string_view{parent.event_s});
+  h.add(std::string_view{parent.skip});
+  h.add(std::string_view{parent.kill});
+  h.add(s.startTimeSync().id_val());
+
+  auto metadata = [&](const auto& element) {
+    h.add(element.metadata().getName());
+    h.add(element.metadata().getLabel());
+  };
+  for (const TimeSyncModel& timenode : s.timeSyncs)
+  {
+    h.add(timenode.id_val());
+    h.add(timenode.active());
+    h.add(timenode.expression().toString());
+    h.add(timenode.date());
+    metadata(timenode);
   }
+  for (const EventModel& event : s.events)
+  {
+    h.add(event.id_val());
+    h.add(parentTimeSync(event, s).id_val());
+    h.add(event.condition().toString());
+    metadata(event);
+  }
+  for (const IntervalModel& c : s.intervals)
+  {
+    h.add(c.id_val());
+    h.add(startEvent(c, s).id_val());
+    h.add(endTimeSync(c, s).id_val());
+    h.add(c.duration.isRigid());
+    h.add(c.duration.defaultDuration());
+    h.add(c.duration.minDuration());
+    h.add(c.duration.maxDuration());
+    h.add(c.duration.isMaxInfinite());
+    metadata(c);
+    for (const auto& process : c.processes)
+      if (dynamic_cast<const Scenario::ProcessModel*>(&process))
+        h.add(process.id_val());
+  }
+  return h.value();
+}
 
-  return str;
+static TAScenario::ParentInterval
+parentInterval(const ScenarioContent& content, const ScenarioContent::Child& child)
+{
+  return {
+      std::string{content.symbols.view(child.event_s)},
+      std::string{content.symbols.view(child.skip)},
+      std::string{content.symbols.view(child.kill)}};
 }
 
-static void insert(TA::ScenarioContent& source, TA::ScenarioContent& dest)
+// Converts a sub-scenario in a task of its own, into its own content. A
+// sub-scenario found in the cache is copied from there, and only its own
+// sub-scenarios are looked at.
+static void convertChild(
+    const Scenario::ProcessModel& scenario,
+    TAScenario::ParentInterval parent,
+    ScenarioContent& child,
+    NameCache names,
+    TaskGroup& tasks,
+    FragmentCache* cache)
 {
-  dest.rigids.splice(dest.rigids.end(), source.rigids);
-  dest.flexibles.splice(dest.flexibles.end(), source.flexibles);
-  dest.points.splice(dest.points.end(), source.points);
-  dest.events.splice(dest.events.end(), source.events);
-  dest.events_nd.splice(dest.events_nd.end(), source.events_nd);
-  dest.mixs.splice(dest.mixs.end(), source.mixs);
-  dest.controls.splice(dest.controls.end(), source.controls);
+  tasks.run([&scenario,
+             parent = std::move(parent),
+             &child,
+             names = std::move(names),
+             &tasks,
+             cache]() mutable {
+    const std::string& name = names(scenario);
+    uint64_t key{};
+    if (cache)
+    {
+      key = fragmentKey(scenario, name, parent);
+      if (const auto fragment = cache->find(key))
+      {
+        fragment->restore(child);
+
+        // In the order of TAVisitor
+        std::size_t i = 0;
+        for (const Scenario::IntervalModel& c : scenario.intervals)
+        {
+          for (const auto& process : c.processes)
+          {
+            if (auto sub
+                = dynamic_cast<const Scenario::ProcessModel*>(&process))
+            {
+              auto& sub_child = child.children[i++];
+              convertChild(
+                  *sub,
+                  parentInterval(child, sub_child),
+                  *sub_child.content,
+                  NameCache{*sub, names(*sub)},
+                  tasks,
+                  cache);
+            }
+          }
+        }
+        SCORE_ASSERT(i == child.children.size());
+        return;
+      }
+    }
+
+    child.name = child.symbols.intern(name);
+    TAVisitor v{scenario, parent, child, names, tasks, cache};
 
-  dest.bools.insert(source.bools.begin(), source.bools.end());
-  dest.ints.insert(source.ints.begin(), source.ints.end());
-  dest.broadcasts.insert(source.broadcasts.begin(), source.broadcasts.end());
+    for (const TA::Point& point : child.points)
+    {
+      SCORE_ASSERT(point.event_s != NoSymbol);
+      SCORE_ASSERT(point.event_e != NoSymbol);
+      SCORE_ASSERT(point.skip_p != NoSymbol);
+    }
+
+    // The contents of its children are still being converted, but not
+    // their positions.
+    if (cache)
+    {
+      child.key = key;
+      cache->insert(key, std::make_shared<const FragmentCache::Fragment>(child));
+    }
+  });
 }
 
 template <typename T>
 static void visitProcesses(
     const Scenario::IntervalModel& c,
     const T& ta_cst,
-    TA::ScenarioContent& content)
+    TA::ScenarioContent& content,
+    NameCache& names,
+    TaskGroup& tasks,
+    FragmentCache* cache)
 {
   for (const auto& process : c.processes)
   {
     if (auto scenario = dynamic_cast<const Scenario::ProcessModel*>(&process))
     {
-      TAVisitor v{*scenario, ta_cst};
-
-      for (const TA::Point& point : v.scenario.points)
-      {
-        SCORE_ASSERT(!point.event_s.isEmpty());
-        SCORE_ASSERT(!point.event_e.isEmpty());
-        SCORE_ASSERT(!point.skip_p.isEmpty());
-      }
-
-      insert(v.scenario, content);
+      // Sub-scenarios do not share any channel with their siblings : each
+      // one is converted in its own task, into its own content.
+      ScenarioContent& child
+          = content.addChild(ta_cst.event_s, ta_cst.skip, ta_cst.kill);
+      convertChild(
+          *scenario,
+          parentInterval(content, content.children.back()),
+          child,
+          NameCache{*scenario, names(*scenario)},
+          tasks,
+          cache);
     }
   }
 }
 
-QString makeScenario(const Scenario::IntervalModel& c)
+// Comments are made from the metadata of the elements.
+template <typename T>
+static Symbol
+comment(SymbolTable& symbols, const char* kind, const T& element)
+{
+  return symbols.intern(
+      kind,
+      element.metadata().getName().toStdString(),
+      ". Label : ",
+      element.metadata().getLabel().toStdString());
+}
+
+ScenarioContent
+makeContent(const Scenario::IntervalModel& c, const ExportOptions& options)
 {
   using namespace Scenario;
   // Our register of elements
   ScenarioContent baseContent;
+  auto& symbols = baseContent.symbols;
+  NameCache names;
 
   // Global play
-  TA::Event scenario_start_event{"MainStartEvent",
-                                 IntVariable{"msg_start"},
-                                 BroadcastVariable{"global_start"},
+  TA::Event scenario_start_event{symbols.intern("MainStartEvent"),
+                                 symbols.intern("msg_start"),
+                                 symbols.intern("global_start"),
                                  TimeVal::zero(),
                                  1};
-  TA::Event scenario_end_event{"MainEndEvent",
-                               IntVariable{"msg_end"},
-                               BroadcastVariable{"global_end"},
+  TA::Event scenario_end_event{symbols.intern("MainEndEvent"),
+                               symbols.intern("msg_end"),
+                               symbols.intern("global_end"),
                                TimeVal::fromMsecs(18000),
                                1};
 
-  QString cst_name = name(c);
+  const std::string& cst_name = names(c);
 
   // Setup of the rigid
-  TA::Flexible base{cst_name};
+  TA::Flexible base{symbols.intern(cst_name)};
   base.dmin = TimeVal::zero();
   base.dmax = c.duration.maxDuration();
   base.finite = false;
 
   base.event_s = scenario_start_event.event;
-  base.event_min = "event_e1" + cst_name;
+  base.event_min = symbols.intern("event_e1", cst_name);
   base.event_i = scenario_end_event.event;
-  base.event_max = "event_e2" + cst_name;
+  base.event_max = symbols.intern("event_e2", cst_name);
 
-  base.skip_p = "skip_p" + cst_name;
-  base.kill_p = "kill_p" + cst_name;
+  base.skip_p = symbols.intern("skip_p", cst_name);
+  base.kill_p = symbols.intern("kill_p", cst_name);
 
-  base.skip = "skip" + cst_name;
-  base.kill = "kill" + cst_name;
+  base.skip = symbols.intern("skip", cst_name);
+  base.kill = symbols.intern("kill", cst_name);
 
   // Register all the new elements
   baseContent.flexibles.push_back(base);
 
-  baseContent.broadcasts.insert(base.event_min);
-  baseContent.broadcasts.insert(base.event_i);
-  baseContent.broadcasts.insert(base.event_max);
-  baseContent.broadcasts.insert(base.skip);
-  baseContent.broadcasts.insert(base.kill);
-  baseContent.broadcasts.insert(base.skip_p);
-  baseContent.broadcasts.insert(base.kill_p);
+  baseContent.broadcasts.insert(
+      baseContent.broadcasts.end(),
+      {base.event_min,
+       base.event_i,
+       base.event_max,
+       base.skip,
+       base.kill,
+       base.skip_p,
+       base.kill_p});
 
   baseContent.events.push_back(scenario_start_event);
-  baseContent.ints.insert(scenario_start_event.message);
+  baseContent.ints.push_back(scenario_start_event.message);
   baseContent.events.push_back(scenario_end_event);
-  baseContent.ints.insert(scenario_end_event.message);
+  baseContent.ints.push_back(scenario_end_event.message);
 
   TA::Mix scenario_end_mix{
-      "EndMix", base.event_max, base.kill, base.skip_p, base.kill_p};
+      symbols.intern("EndMix"), base.event_max, base.kill, base.skip_p,
+      base.kill_p};
 
   baseContent.mixs.push_back(scenario_end_mix);
 
-  visitProcesses(c, base, baseContent);
+  if (options.cache)
+    options.cache->nextExport();
+
+  TaskGroup tasks;
+  visitProcesses(c, base, baseContent, names, tasks, options.cache);
+  tasks.wait();
+
+  if (options.compose)
+    compose(baseContent);
+
+  if (options.slice && !slice(baseContent, names(*options.slice)))
+    qWarning("UPPAAL export: no automaton to slice to, exporting everything");
+
+  if (options.reduce)
+    reduce(baseContent);
 
-  return print(baseContent);
+  return baseContent;
+}
+
+bool makeScenario(
+    const Scenario::IntervalModel& c,
+    QIODevice& output,
+    const ExportOptions& options)
+{
+  const ScenarioContent content = makeContent(c, options);
+  UppaalWriter writer{output};
+  // The passes which change the content keep the keys of the fragments.
+  const bool changed = options.compose || options.slice || options.reduce;
+  if (options.arrays)
+    printArrays(content, writer);
+  else
+    print(content, writer, changed ? nullptr : options.cache);
+
+  writer.flush();
+  return writer.ok();
 }
 
 const char* TAVisitor::space() const
@@ -350,18 +1233,20 @@ const char* TAVisitor::space() const
 void TAVisitor::visit(const Scenario::TimeSyncModel& timenode)
 {
   using namespace Scenario;
+  auto& content = scenario.content;
+  auto& symbols = content.symbols;
   // First we create a point for the timenode. The ingoing
   // intervals will end on this point.
 
-  QString tn_name = name(timenode);
+  const std::string& tn_name = names(timenode);
   // Create an interaction point.
-  TA::Point tn_point{tn_name};
+  TA::Point tn_point{symbols.intern(tn_name)};
 
   tn_point.kill_p = scenario.kill;
-  tn_point.en = "en_" + tn_name;
-  tn_point.event = "event_" + tn_name;
-  tn_point.skip = "skip_" + tn_name;
-  tn_point.event_t = "ok_" + tn_name;
+  tn_point.en = symbols.intern("en_", tn_name);
+  tn_point.event = symbols.intern("event_", tn_name);
+  tn_point.skip = symbols.intern("skip_", tn_name);
+  tn_point.event_t = symbols.intern("ok_", tn_name);
 
   if (timenode.active())
   {
@@ -372,53 +1257,51 @@ void TAVisitor::visit(const Scenario::TimeSyncModel& timenode)
     tn_point.condition = 0;
     tn_point.conditionValue = 0;
   }
-  tn_point.conditionMessage = "msg" + tn_name;
+  tn_point.conditionMessage = symbols.intern("msg", tn_name);
 
   tn_point.urgent = true;
 
-  scenario.bools.insert(tn_point.en);
-  scenario.ints.insert(tn_point.conditionMessage);
-  scenario.broadcasts.insert(tn_point.event);
-  scenario.broadcasts.insert(tn_point.skip);
-  scenario.broadcasts.insert(tn_point.event_t);
+  content.bools.push_back(tn_point.en);
+  content.ints.push_back(tn_point.conditionMessage);
+  content.broadcasts.insert(
+      content.broadcasts.end(),
+      {tn_point.event, tn_point.skip, tn_point.event_t});
 
   // If there are multiple intervals ending on this timenode,
   // we put a Control inbetween.
   auto prev_csts = previousIntervals(timenode, scenario.score_scenario);
   if (prev_csts.size() > 1)
   {
-    QString control_name = "Control_" + tn_name;
     TA::Control ctrl(
-        control_name,
+        symbols.intern("Control_", tn_name),
         prev_csts.size(),
-        "event_s1_" + control_name,
-        "skip_p_" + control_name,
-        "skip_" + control_name,
-        "event_e_" + control_name,
+        symbols.intern("event_s1_Control_", tn_name),
+        symbols.intern("skip_p_Control_", tn_name),
+        symbols.intern("skip_Control_", tn_name),
+        symbols.intern("event_e_Control_", tn_name),
         scenario.kill,
-        "event_s2_" + control_name);
+        symbols.intern("event_s2_Control_", tn_name));
 
-    scenario.controls.push_back(ctrl);
+    content.controls.push_back(ctrl);
 
     tn_point.skip_p = ctrl.skip;
     tn_point.event_e = ctrl.event_s2;
     tn_point.event_s = ctrl.event_e;
 
-    scenario.broadcasts.insert(ctrl.event_s1);
-    scenario.broadcasts.insert(ctrl.skip_p);
-    scenario.broadcasts.insert(ctrl.skip);
-    scenario.broadcasts.insert(ctrl.event_e);
-    scenario.broadcasts.insert(ctrl.event_s2);
+    content.broadcasts.insert(
+        content.broadcasts.end(),
+        {ctrl.event_s1, ctrl.skip_p, ctrl.skip, ctrl.event_e,
+         ctrl.event_s2});
   }
   else if (prev_csts.size() == 1)
   {
-    tn_point.skip_p = "skip_p_" + tn_name;
-    tn_point.event_e = "event_e_" + tn_name;
-    tn_point.event_s = "event_s_" + tn_name;
+    tn_point.skip_p = symbols.intern("skip_p_", tn_name);
+    tn_point.event_e = symbols.intern("event_e_", tn_name);
+    tn_point.event_s = symbols.intern("event_s_", tn_name);
 
-    scenario.broadcasts.insert(tn_point.skip_p);
-    scenario.broadcasts.insert(tn_point.event_e);
-    scenario.broadcasts.insert(tn_point.event_s);
+    content.broadcasts.insert(
+        content.broadcasts.end(),
+        {tn_point.skip_p, tn_point.event_e, tn_point.event_s});
   }
   else if (&timenode == &scenario.score_scenario.startTimeSync())
   {
@@ -435,41 +1318,41 @@ void TAVisitor::visit(const Scenario::TimeSyncModel& timenode)
 
   if (timenode.active())
   {
-    TA::Event_ND node_event{"EventND_" + tn_name,
+    TA::Event_ND node_event{symbols.intern("EventND_", tn_name),
                             tn_point.conditionMessage,
                             tn_point.event,
                             timenode.date(), // TODO throw a rand
                             0};
 
-    scenario.events_nd.push_back(node_event);
+    content.events_nd.push_back(node_event);
   }
   else
   {
-    TA::Event node_event{"Event_" + tn_name,
+    TA::Event node_event{symbols.intern("Event_", tn_name),
                          tn_point.conditionMessage,
                          tn_point.event,
                          timenode.date(), // TODO throw a rand
                          0};
 
-    scenario.events.push_back(node_event);
+    content.events.push_back(node_event);
   }
 
   if (!timenode.active())
   {
     // TODO
-    TA::Mix point_start_mix{"Mix_" + tn_name,
+    const std::string mix_event_e{symbols.view(tn_point.event_e)};
+    TA::Mix point_start_mix{symbols.intern("Mix_", tn_name),
                             tn_point.event_s,
-                            "mix_event_e" + tn_point.event_e,
+                            symbols.intern("mix_event_e", mix_event_e),
                             tn_point.skip_p,
                             tn_point.kill_p};
 
     tn_point.event_e = point_start_mix.event_out;
-    scenario.broadcasts.insert(point_start_mix.event_out);
-    scenario.mixs.push_back(point_start_mix);
+    content.broadcasts.push_back(point_start_mix.event_out);
+    content.mixs.push_back(point_start_mix);
   }
 
-  tn_point.comment = "TimeSync Name : " + timenode.metadata().getName()
-                     + ". Label : " + timenode.metadata().getLabel();
+  tn_point.comment = comment(symbols, "TimeSync Name : ", timenode);
 
   /*
   // We create a flexible that will go to each event of the timenode.
@@ -497,35 +1380,36 @@ void TAVisitor::visit(const Scenario::TimeSyncModel& timenode)
   scenario.broadcasts.insert(flexible.skip);
   scenario.broadcasts.insert(flexible.kill);
 */
-  scenario.points.push_back(tn_point);
+  m_timeSyncPoints.emplace(&timenode, content.points.size());
+  content.points.push_back(tn_point);
 }
 
 void TAVisitor::visit(const Scenario::EventModel& event)
 {
   using namespace Scenario;
+  auto& content = scenario.content;
+  auto& symbols = content.symbols;
   const auto& timenode = parentTimeSync(event, scenario.score_scenario);
-  QString tn_name = name(timenode);
-  auto it = ossia::find_if(scenario.points, [&](const auto& point) {
-    return point.name == tn_name;
-  });
-  SCORE_ASSERT(it != scenario.points.end());
+  auto it = m_timeSyncPoints.find(&timenode);
+  SCORE_ASSERT(it != m_timeSyncPoints.end());
 
-  const TA::Point& previous_timenode_point = *it;
-  QString event_name = name(event);
+  // Copied : the points may move when this event's point is added.
+  const TA::Point previous_timenode_point = content.points[it->second];
+  const std::string& event_name = names(event);
 
-  TA::Point point{event_name};
+  TA::Point point{symbols.intern(event_name)};
 
   // TODO condition
   // TODO states
 
-  point.en = "en_" + event_name;
-  point.skip = "skip_" + event_name;
-  point.event = "event_" + event_name;
-  point.event_t = "ok_" + event_name;
-  point.event_e = "emax_" + event_name;
+  point.en = symbols.intern("en_", event_name);
+  point.skip = symbols.intern("skip_", event_name);
+  point.event = symbols.intern("event_", event_name);
+  point.event_t = symbols.intern("ok_", event_name);
+  point.event_e = symbols.intern("emax_", event_name);
 
   set_point_condition(point, event.condition());
-  point.conditionMessage = "msg" + event_name;
+  point.conditionMessage = symbols.intern("msg", event_name);
 
   point.event_s = previous_timenode_point.event_e;
   point.skip_p = previous_timenode_point.skip;
@@ -534,36 +1418,34 @@ void TAVisitor::visit(const Scenario::EventModel& event)
 
   point.urgent = true;
 
-  point.comment = "EventNode Name : " + event.metadata().getName()
-                  + ". Label : " + event.metadata().getLabel();
+  point.comment = comment(symbols, "EventNode Name : ", event);
   if (!event.condition().hasChildren())
   {
     // No condition
-    TA::Mix point_start_mix{"Mix_" + event_name,
+    TA::Mix point_start_mix{symbols.intern("Mix_", event_name),
                             previous_timenode_point.event_e,
                             point.event_e,
                             point.skip_p,
                             point.kill_p};
 
-    scenario.mixs.push_back(point_start_mix);
+    content.mixs.push_back(point_start_mix);
   }
 
-  TA::Event node_event{"Event_" + event_name,
+  TA::Event node_event{symbols.intern("Event_", event_name),
                        point.conditionMessage,
                        point.event_e,
                        timenode.date(), // TODO throw a rand
                        0};
 
-  scenario.events.push_back(node_event);
+  content.events.push_back(node_event);
 
-  scenario.points.push_back(point);
+  content.points.push_back(point);
 
-  scenario.bools.insert(point.en);
-  scenario.ints.insert(point.conditionMessage);
-  scenario.broadcasts.insert(point.skip);
-  scenario.broadcasts.insert(point.event);
-  scenario.broadcasts.insert(point.event_t);
-  scenario.broadcasts.insert(point.event_e);
+  content.bools.push_back(point.en);
+  content.ints.push_back(point.conditionMessage);
+  content.broadcasts.insert(
+      content.broadcasts.end(),
+      {point.skip, point.event, point.event_t, point.event_e});
 
   // We already linked the start of this event, with
   // the end of the flexible created in the timenode pass
@@ -574,6 +1456,7 @@ void TAVisitor::visit(const Scenario::StateModel& state) {}
 void TAVisitor::visit(const Scenario::ProcessModel& s)
 {
   using namespace Scenario;
+  m_timeSyncPoints.reserve(s.timeSyncs.size());
   for (const TimeSyncModel& timenode : s.timeSyncs)
   {
     visit(timenode);
@@ -598,39 +1481,41 @@ void TAVisitor::visit(const Scenario::ProcessModel& s)
 void TAVisitor::visit(const Scenario::IntervalModel& c)
 {
   using namespace Scenario;
-  QString start_event_name = name(startEvent(c, scenario.score_scenario));
+  auto& content = scenario.content;
+  auto& symbols = content.symbols;
+  const std::string& start_event_name
+      = names(startEvent(c, scenario.score_scenario));
 
   const TimeSyncModel& end_node = endTimeSync(c, scenario.score_scenario);
-  QString end_node_name = name(end_node);
+  const std::string& end_node_name = names(end_node);
 
   auto prev_csts = previousIntervals(end_node, scenario.score_scenario);
-  QString event_e1;
-  QString event_e2;
-  QString skip;
+  TA::BroadcastVariable event_e1;
+  TA::BroadcastVariable event_e2;
+  TA::BroadcastVariable skip;
   if (prev_csts.size() > 1)
   {
-    QString control_name = "Control_" + end_node_name;
     // We use the control.
-    event_e1 = "event_s1_" + control_name;
-    event_e2 = "event_s2_" + control_name;
-    skip = "skip_p_" + control_name;
+    event_e1 = symbols.intern("event_s1_Control_", end_node_name);
+    event_e2 = symbols.intern("event_s2_Control_", end_node_name);
+    skip = symbols.intern("skip_p_Control_", end_node_name);
   }
   else
   {
-    event_e1 = "event_s_" + end_node_name;
-    event_e2 = "event_e_" + end_node_name;
-    skip = "skip_p_" + end_node_name;
+    event_e1 = symbols.intern("event_s_", end_node_name);
+    event_e2 = symbols.intern("event_e_", end_node_name);
+    skip = symbols.intern("skip_p_", end_node_name);
   }
 
-  QString cst_name = name(c);
+  const std::string& cst_name = names(c);
 
   if (c.duration.isRigid())
   {
     // Setup of the rigid
-    TA::Rigid rigid{cst_name};
+    TA::Rigid rigid{symbols.intern(cst_name)};
     rigid.dur = c.duration.defaultDuration();
 
-    rigid.event_s = "ok_" + start_event_name;
+    rigid.event_s = symbols.intern("ok_", start_event_name);
 
     // skip_p : skip precedent
     // kill_p : kill parent
@@ -638,7 +1523,7 @@ void TAVisitor::visit(const Scenario::IntervalModel& c)
         = scenario.skip; // TODO this must be the skip of the start event.
     rigid.kill_p = scenario.kill;
 
-    rigid.kill = "kill_" + cst_name;
+    rigid.kill = symbols.intern("kill_", cst_name);
 
     // Link with the end points
     rigid.event_e1 = event_e1;
@@ -646,24 +1531,22 @@ void TAVisitor::visit(const Scenario::IntervalModel& c)
     rigid.skip = skip;
 
     // Register all the new elements
-    rigid.comment = "Name : " + c.metadata().getName()
-                    + ". Label : " + c.metadata().getLabel();
-    scenario.rigids.push_back(rigid);
-    scenario.broadcasts.insert(rigid.event_s);
-    scenario.broadcasts.insert(rigid.skip);
-    scenario.broadcasts.insert(rigid.kill);
+    rigid.comment = comment(symbols, "Name : ", c);
+    content.rigids.push_back(rigid);
+    content.broadcasts.insert(
+        content.broadcasts.end(), {rigid.event_s, rigid.skip, rigid.kill});
 
-    visitProcesses(c, rigid, scenario);
+    visitProcesses(c, rigid, content, names, tasks, cache);
   }
   else
   {
-    TA::Flexible flexible{cst_name};
+    TA::Flexible flexible{symbols.intern(cst_name)};
 
     flexible.dmin = c.duration.minDuration();
     flexible.dmax = c.duration.maxDuration();
     flexible.finite = !c.duration.isMaxInfinite();
 
-    flexible.event_s = "ok_" + start_event_name;
+    flexible.event_s = symbols.intern("ok_", start_event_name);
     flexible.skip_p
         = scenario.skip; // TODO this must be the skip of the start event.
     flexible.kill_p = scenario.kill;
@@ -677,17 +1560,15 @@ void TAVisitor::visit(const Scenario::IntervalModel& c)
     // no event_e_Node anywhere."event_e_" + end_node_name;
     flexible.event_i = event_e2;
 
-    QString cst_name = name(c);
-    flexible.kill = "kill_" + cst_name;
+    flexible.kill = symbols.intern("kill_", cst_name);
 
-    flexible.comment = "Name : " + c.metadata().getName()
-                       + ". Label : " + c.metadata().getLabel();
-    scenario.flexibles.push_back(flexible);
-    scenario.broadcasts.insert(flexible.event_s);
-    scenario.broadcasts.insert(flexible.skip);
-    scenario.broadcasts.insert(flexible.kill);
+    flexible.comment = comment(symbols, "Name : ", c);
+    content.flexibles.push_back(flexible);
+    content.broadcasts.insert(
+        content.broadcasts.end(),
+        {flexible.event_s, flexible.skip, flexible.kill});
 
-    visitProcesses(c, flexible, scenario);
+    visitProcesses(c, flexible, content, names, tasks, cache);
   }
 }
 
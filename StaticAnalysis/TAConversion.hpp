@@ -7,14 +7,17 @@
 #include <Scenario/Process/ScenarioModel.hpp>
 #include <Scenario/Process/ScenarioProcessMetadata.hpp>
 
-#include <score/model/path/Path.hpp>
+#include <StaticAnalysis/SymbolTable.hpp>
 
 #include <QString>
 
-#include <ossia/detail/variant.hpp>
+#include <array>
+#include <memory>
 
-#include <set>
 #include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 namespace Scenario
 {
 class TimeSyncModel;
@@ -23,74 +26,78 @@ class IntervalModel;
 class StateModel;
 class ProcessModel;
 }
+class QIODevice;
 namespace stal
 {
+class TaskGroup;
 namespace TA
 {
 struct TAScenario;
+class FragmentCache;
 
 
-inline QString name(const QObject& obj)
+/**
+ * @brief Names of the elements of a score, memoized for one export.
+ *
+ * The name of an element is its own segment, e.g. "E3", followed by the
+ * name of its parent : once the parent is known, naming an element is a
+ * single append.
+ */
+class NameCache
 {
-  ObjectPath path = score::IDocument::unsafe_path(obj);
+public:
+  NameCache() = default;
 
-  path.vec().erase(path.vec().begin(), path.vec().begin() + 2);
-  std::reverse(path.vec().begin(), path.vec().end());
-  for (ObjectIdentifier& elt : path.vec())
+  //! Cache for the elements below an object whose name is already known.
+  NameCache(const QObject& root, std::string name)
   {
-    if (elt.objectName()
-        == Metadata<ObjectKey_k, Scenario::ProcessModel>::get())
-      elt = ObjectIdentifier{"S", elt.id()};
-    else if (
-        elt.objectName() == Metadata<ObjectKey_k, Scenario::EventModel>::get())
-      elt = ObjectIdentifier{"E", elt.id()};
-    else if (elt.objectName().contains("Interval"))
-      elt = ObjectIdentifier{"C", elt.id()};
-    else if (
-        elt.objectName()
-        == Metadata<ObjectKey_k, Scenario::TimeSyncModel>::get())
-      elt = ObjectIdentifier{"T", elt.id()};
+    m_names.emplace(&root, std::move(name));
   }
 
-  auto str = path.toString().replace('/', "_").replace('.', "");
-  str.resize(str.size() - 1);
-  return str;
-}
+  const std::string& operator()(const QObject& obj);
+
+private:
+  std::unordered_map<const QObject*, std::string> m_names;
+};
+
+//! Condition values of the points are divided by this factor when exported.
+constexpr int uppaal_division_factor = 100;
 
-using BroadcastVariable = QString;
-using BoolVariable = QString;
-using IntVariable = QString;
+// Channels and variables are symbols of the ScenarioContent.
+using BroadcastVariable = Symbol;
+using BoolVariable = Symbol;
+using IntVariable = Symbol;
 struct Event
 {
-  Event(QString n, IntVariable a, BroadcastVariable b, TimeVal c, int d)
+  Event(Symbol n, IntVariable a, BroadcastVariable b, TimeVal c, int d)
       : name{n}, message{a}, event{b}, date{c}, val{d}
   {
   }
 
-  QString name;
-  IntVariable message{};
-  BroadcastVariable event{};
+  Symbol name;
+  IntVariable message{NoSymbol};
+  BroadcastVariable event{NoSymbol};
   TimeVal date{};
   int val{};
 };
 
 struct Event_ND
 {
-  Event_ND(QString n, IntVariable a, BroadcastVariable b, TimeVal c, int d)
+  Event_ND(Symbol n, IntVariable a, BroadcastVariable b, TimeVal c, int d)
       : name{n}, message{a}, event{b}, date{c}, val{d}
   {
   }
 
-  QString name;
-  IntVariable message{};
-  BroadcastVariable event{};
+  Symbol name;
+  IntVariable message{NoSymbol};
+  BroadcastVariable event{NoSymbol};
   TimeVal date{};
   int val{};
 };
 
 struct Mix
 {
-  Mix(QString name,
+  Mix(Symbol name,
       BroadcastVariable a,
       BroadcastVariable b,
       BroadcastVariable c,
@@ -99,7 +106,7 @@ struct Mix
   {
   }
 
-  QString name;
+  Symbol name;
   BroadcastVariable event_in;
   BroadcastVariable event_out;
   BroadcastVariable skip_p;
@@ -109,7 +116,7 @@ struct Mix
 struct Control
 {
   Control(
-      QString name,
+      Symbol name,
       int num,
       BroadcastVariable a,
       BroadcastVariable b,
@@ -128,7 +135,7 @@ struct Control
   {
   }
 
-  QString name;
+  Symbol name;
   int num_prev_rels = 0;
   BroadcastVariable event_s1;
   BroadcastVariable skip_p;
@@ -140,120 +147,200 @@ struct Control
 
 struct Point
 {
-  Point(const QString& name) : name{name} {}
+  Point(Symbol name) : name{name} {}
 
-  QString name;
+  Symbol name;
   int condition{};
   int conditionValue{};
-  BoolVariable en; // Enabled
-  IntVariable conditionMessage;
+  BoolVariable en{NoSymbol}; // Enabled
+  IntVariable conditionMessage{NoSymbol};
 
-  BroadcastVariable event;
+  BroadcastVariable event{NoSymbol};
 
   bool urgent = true;
 
-  BroadcastVariable event_s;
-  BroadcastVariable skip_p;
-  BroadcastVariable event_e;
-  BroadcastVariable kill_p;
+  BroadcastVariable event_s{NoSymbol};
+  BroadcastVariable skip_p{NoSymbol};
+  BroadcastVariable event_e{NoSymbol};
+  BroadcastVariable kill_p{NoSymbol};
 
-  BroadcastVariable skip;
-  BroadcastVariable event_t;
+  BroadcastVariable skip{NoSymbol};
+  BroadcastVariable event_t{NoSymbol};
 
-  QString comment;
+  Symbol comment{NoSymbol};
 };
 
 struct Flexible
 {
-  Flexible(const QString& name) : name{name} {}
+  Flexible(Symbol name) : name{name} {}
 
-  QString name;
+  Symbol name;
 
   TimeVal dmin;
   TimeVal dmax;
   bool finite = true;
 
-  BroadcastVariable event_s;
-  BroadcastVariable event_min;
-  BroadcastVariable event_i;
-  BroadcastVariable event_max;
+  BroadcastVariable event_s{NoSymbol};
+  BroadcastVariable event_min{NoSymbol};
+  BroadcastVariable event_i{NoSymbol};
+  BroadcastVariable event_max{NoSymbol};
 
-  BroadcastVariable skip_p;
-  BroadcastVariable kill_p;
-  BroadcastVariable skip;
-  BroadcastVariable kill;
+  BroadcastVariable skip_p{NoSymbol};
+  BroadcastVariable kill_p{NoSymbol};
+  BroadcastVariable skip{NoSymbol};
+  BroadcastVariable kill{NoSymbol};
 
-  QString comment;
+  Symbol comment{NoSymbol};
 };
 
 struct Rigid
 {
-  Rigid(const QString& name) : name{name} {}
+  Rigid(Symbol name) : name{name} {}
 
-  QString name;
+  Symbol name;
 
   TimeVal dur;
 
-  BroadcastVariable event_s;
-  BroadcastVariable event_e1;
+  BroadcastVariable event_s{NoSymbol};
+  BroadcastVariable event_e1{NoSymbol};
 
-  BroadcastVariable skip_p;
-  BroadcastVariable kill_p;
-  BroadcastVariable skip;
-  BroadcastVariable kill;
+  BroadcastVariable skip_p{NoSymbol};
+  BroadcastVariable kill_p{NoSymbol};
+  BroadcastVariable skip{NoSymbol};
+  BroadcastVariable kill{NoSymbol};
 
-  BroadcastVariable event_e2;
+  BroadcastVariable event_e2{NoSymbol};
 
-  QString comment;
+  Symbol comment{NoSymbol};
 };
 
-using Interval = ossia::variant<Rigid, Flexible>;
-
+/**
+ * @brief The automata and variables of a scenario and its sub-scenarios.
+ *
+ * The strings are interned in a symbol table, and the automata are stored
+ * by value in the order they were created. Each sub-scenario has its own
+ * content, so that sibling sub-scenarios can be converted in parallel :
+ * it remembers how many automata of each kind its parent had when it was
+ * added, which gives back the order of a sequential conversion when
+ * printing. Variables may be declared more than once : they are
+ * deduplicated when printed.
+ */
 struct ScenarioContent
 {
-  std::set<TA::BroadcastVariable> broadcasts;
-  std::set<TA::IntVariable> ints;
-  std::set<TA::BoolVariable> bools;
-
-  std::list<TA::Rigid> rigids;
-  std::list<TA::Flexible> flexibles;
-  std::list<TA::Point> points;
-  std::list<TA::Event> events;
-  std::list<TA::Event_ND> events_nd;
-  std::list<TA::Mix> mixs;
-  std::list<TA::Control> controls;
+  SymbolTable symbols;
+
+  std::vector<TA::BroadcastVariable> broadcasts;
+  std::vector<TA::IntVariable> ints;
+  std::vector<TA::BoolVariable> bools;
+
+  std::vector<TA::Rigid> rigids;
+  std::vector<TA::Flexible> flexibles;
+  std::vector<TA::Point> points;
+  std::vector<TA::Event> events;
+  std::vector<TA::Event_ND> events_nd;
+  std::vector<TA::Mix> mixs;
+  std::vector<TA::Control> controls;
+
+  struct Position
+  {
+    std::size_t rigids, flexibles, points, events, events_nd, mixs, controls;
+  };
+  struct Child
+  {
+    Position position;
+    //! Channels of the interval which contains the sub-scenario.
+    TA::BroadcastVariable event_s{NoSymbol};
+    TA::BroadcastVariable skip{NoSymbol};
+    TA::BroadcastVariable kill{NoSymbol};
+    std::unique_ptr<ScenarioContent> content;
+  };
+  std::vector<Child> children;
+
+  //! Of a sub-scenario : its name, and the channels of the interval which
+  //! contains it.
+  Symbol name{NoSymbol};
+  TA::BroadcastVariable event_s{NoSymbol};
+  TA::BroadcastVariable skip{NoSymbol};
+  TA::BroadcastVariable kill{NoSymbol};
+  //! Of a sub-scenario : its key in a FragmentCache, or 0.
+  uint64_t key{};
+
+  //! Adds the content of a sub-scenario after the current automata.
+  ScenarioContent& addChild(
+      TA::BroadcastVariable event_s,
+      TA::BroadcastVariable skip,
+      TA::BroadcastVariable kill)
+  {
+    Position pos{
+        rigids.size(),
+        flexibles.size(),
+        points.size(),
+        events.size(),
+        events_nd.size(),
+        mixs.size(),
+        controls.size()};
+    return *children
+                .emplace_back(Child{
+                    pos,
+                    event_s,
+                    skip,
+                    kill,
+                    std::make_unique<ScenarioContent>()})
+                .content;
+  }
 };
 
-struct TAScenario : public ScenarioContent
+struct TAScenario
 {
-  template <typename T>
-  TAScenario(const Scenario::ProcessModel& s, const T& interval)
-      : score_scenario{s}
-      , self{interval}
-      , event_s{interval.event_s}
-      , skip{interval.skip}
-      , kill{interval.kill}
+  //! Channels of the interval which contains the scenario.
+  struct ParentInterval
   {
-    broadcasts.insert(event_s);
-    broadcasts.insert(skip);
-    broadcasts.insert(kill);
+    std::string event_s;
+    std::string skip;
+    std::string kill;
+  };
+
+  TAScenario(
+      const Scenario::ProcessModel& s,
+      const ParentInterval& interval,
+      ScenarioContent& content)
+      : content{content}
+      , score_scenario{s}
+      , event_s{content.symbols.intern(interval.event_s)}
+      , skip{content.symbols.intern(interval.skip)}
+      , kill{content.symbols.intern(interval.kill)}
+  {
+    content.event_s = event_s;
+    content.skip = skip;
+    content.kill = kill;
+    content.broadcasts.push_back(event_s);
+    content.broadcasts.push_back(skip);
+    content.broadcasts.push_back(kill);
   }
 
+  ScenarioContent& content;
   const Scenario::ProcessModel& score_scenario;
 
-  TA::Interval self; // The scenario is considered similar to a interval.
-
-  const TA::BroadcastVariable event_s; // = "skip_S" + name(score_scenario);
-  const TA::BroadcastVariable skip;    // = "skip_S" + name(score_scenario);
-  const TA::BroadcastVariable kill;    // = "kill_S" + name(score_scenario);
+  // The scenario is considered similar to its parent interval.
+  const TA::BroadcastVariable event_s;
+  const TA::BroadcastVariable skip;
+  const TA::BroadcastVariable kill;
 };
 
 struct TAVisitor
 {
   TA::TAScenario scenario;
-  template <typename T>
-  TAVisitor(const Scenario::ProcessModel& s, const T& interval)
-      : scenario{s, interval}
+  TAVisitor(
+      const Scenario::ProcessModel& s,
+      const TAScenario::ParentInterval& interval,
+      ScenarioContent& content,
+      NameCache& names,
+      TaskGroup& tasks,
+      FragmentCache* cache = nullptr)
+      : scenario{s, interval, content}
+      , names{names}
+      , tasks{tasks}
+      , cache{cache}
   {
     visit(s);
   }
@@ -262,6 +349,14 @@ private:
   int depth = 0;
   const char* space() const;
 
+  NameCache& names;
+  TaskGroup& tasks;
+  FragmentCache* cache{};
+
+  // Index in the points of each time sync, filled by the time sync pass.
+  std::unordered_map<const Scenario::TimeSyncModel*, std::size_t>
+      m_timeSyncPoints;
+
   void visit(const Scenario::TimeSyncModel& timenode);
   void visit(const Scenario::EventModel& event);
   void visit(const Scenario::IntervalModel& c);
@@ -269,6 +364,82 @@ private:
   void visit(const Scenario::ProcessModel& s);
 };
 
-QString makeScenario(const Scenario::IntervalModel& s);
+/**
+ * @brief Buffered text output to a device.
+ *
+ * The text goes through a fixed-size buffer which is written to the device
+ * whenever it is full, so the whole document never has to be in memory.
+ */
+class UppaalWriter
+{
+public:
+  explicit UppaalWriter(QIODevice& device) noexcept : m_device{device} {}
+  ~UppaalWriter() { flush(); }
+
+  UppaalWriter(const UppaalWriter&) = delete;
+  UppaalWriter& operator=(const UppaalWriter&) = delete;
+
+  UppaalWriter& operator<<(std::string_view str);
+  UppaalWriter& operator<<(const char* str)
+  {
+    return *this << std::string_view{str};
+  }
+  UppaalWriter& operator<<(int value);
+
+  void flush();
+
+  //! False once a write to the device failed.
+  bool ok() const noexcept { return m_ok; }
+
+private:
+  void write(const char* data, std::size_t size);
+
+  QIODevice& m_device;
+  std::array<char, 16384> m_buffer;
+  std::size_t m_size{};
+  bool m_ok{true};
+};
+
+//! Options of the UPPAAL export.
+struct ExportOptions
+{
+  //! Simplify the automata network before writing it, see TA::reduce.
+  bool reduce{false};
+
+  //! Interval or time sync : only the automata which can influence it are
+  //! exported, see TA::slice.
+  const QObject* slice{};
+
+  //! Replace the sub-scenarios whose end is bounded by a single Flexible,
+  //! see TA::compose.
+  bool compose{false};
+
+  //! Declare the channels and variables as arrays, and instantiate each
+  //! template from tables of parameters, instead of one declaration per
+  //! channel and automaton : the model of a large score gets much smaller.
+  bool arrays{false};
+
+  //! Sub-scenarios which did not change since a previous export are taken
+  //! from there, see TA::FragmentCache.
+  FragmentCache* cache{};
+};
+
+//! Converts an interval and all its sub-scenarios to automata.
+ScenarioContent makeContent(
+    const Scenario::IntervalModel& s,
+    const ExportOptions& options = {});
+
+/**
+ * @brief Writes the UPPAAL model of an interval and all its sub-scenarios.
+ *
+ * Durations are written in the largest time unit which divides all of
+ * them, given in a comment of the declarations.
+ *
+ * @return false if the device did not take the whole model.
+ */
+bool makeScenario(
+    const Scenario::IntervalModel& s,
+    QIODevice& output,
+    const ExportOptions& options = {});
 }
 }
@@ -0,0 +1,560 @@
+#include "TAExplorer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <numeric>
+
+namespace stal
+{
+namespace TA
+{
+namespace
+{
+using Update = TANetwork::Update;
+
+// States taken from the frontier by a task.
+constexpr std::size_t batchSize = 256;
+}
+
+TAExplorer::TAExplorer(const TANetwork& network, ThreadPool& pool)
+    : m_network{network}, m_pool{pool}
+{
+  layout();
+}
+
+void TAExplorer::layout()
+{
+  const auto& procs = m_network.processes();
+
+  int32_t tick = 0;
+  for (const auto& p : procs)
+    if (p.clock >= 0)
+      tick = std::gcd(tick, std::gcd(p.bounds[0], p.bounds[1]));
+  m_tick = tick > 0 ? tick : 1;
+
+  m_bounds.resize(procs.size());
+  m_maxConstants.resize(procs.size());
+  // Time only elapses while a clock is below an invariant, and each
+  // location is visited once : no run ends after the sum of the durations.
+  int64_t horizon = 0;
+  for (std::size_t p = 0; p < procs.size(); p++)
+  {
+    m_bounds[p] = {procs[p].bounds[0] / m_tick, procs[p].bounds[1] / m_tick};
+    m_maxConstants[p] = std::max(m_bounds[p][0], m_bounds[p][1]);
+    if (procs[p].clock >= 0)
+      horizon += int64_t(m_bounds[p][0]) + m_bounds[p][1];
+  }
+  m_horizon = int32_t(
+      std::min<int64_t>(horizon, std::numeric_limits<int32_t>::max() - 1));
+
+  // Values each variable can take, from the updates of the templates
+  const auto& init = m_network.variables();
+  std::vector<int32_t> lo = init;
+  std::vector<int32_t> hi = init;
+  auto reach = [&](int32_t var, int32_t min, int32_t max) {
+    lo[var] = std::min(lo[var], min);
+    hi[var] = std::max(hi[var], max);
+  };
+  for (const auto& p : procs)
+  {
+    for (const auto& edge : m_network.definition(p).edges)
+    {
+      switch (edge.update)
+      {
+        case Update::None:
+          break;
+        case Update::Message:
+          reach(p.msg, p.val, p.val);
+          break;
+        case Update::Enable:
+        case Update::Disable:
+          reach(p.en, 0, 1);
+          break;
+        case Update::Condition:
+          reach(p.cond, 0, 1);
+          break;
+        case Update::Start:
+          reach(p.skip_v, 0, 1);
+          [[fallthrough]];
+        case Update::Skip:
+          // A Control only counts from idle, where counter < n.
+          reach(p.counter, 0, std::max(p.n, 1));
+          break;
+      }
+    }
+  }
+
+  uint32_t bits = 0;
+  m_locationFields.clear();
+  for (const auto& p : procs)
+    m_locationFields.push_back(
+        field(bits, 0, int32_t(m_network.definition(p).locations.size()) - 1));
+
+  m_variableFields.clear();
+  for (std::size_t v = 0; v < init.size(); v++)
+    m_variableFields.push_back(field(bits, lo[v], hi[v]));
+
+  // Clocks past their largest constant are all equivalent.
+  m_clockFields.clear();
+  for (std::size_t p = 0; p < procs.size(); p++)
+    m_clockFields.push_back(
+        field(bits, 0, procs[p].clock >= 0 ? m_maxConstants[p] + 1 : 0));
+
+  m_dateField = field(bits, 0, m_dated ? m_horizon + 1 : 0);
+
+  m_words = std::max<std::size_t>((bits + 63) / 64, 1);
+}
+
+// Fields do not cross words, so that each one is read with a single shift.
+TAExplorer::Field
+TAExplorer::field(uint32_t& bits, int32_t lo, int32_t hi) const noexcept
+{
+  const auto width
+      = uint8_t(std::bit_width(uint64_t(int64_t(hi) - int64_t(lo))));
+  // Constant, possibly past the last word.
+  if (width == 0)
+    return {0, 0, 0, lo};
+  if (bits % 64 + width > 64)
+    bits = (bits / 64 + 1) * 64;
+
+  const Field f{bits / 64, uint8_t(bits % 64), width, lo};
+  bits += width;
+  return f;
+}
+
+void TAExplorer::pack(const State& s, Word* out) const noexcept
+{
+  std::fill_n(out, m_words, Word{});
+  auto put = [&](const Field& f, int32_t value) {
+    out[f.word] |= Word(int64_t(value) - f.bias) << f.shift;
+  };
+
+  for (std::size_t p = 0; p < s.locations.size(); p++)
+  {
+    put(m_locationFields[p], s.locations[p]);
+    put(m_clockFields[p], s.clocks[p]);
+  }
+  for (std::size_t v = 0; v < s.variables.size(); v++)
+    put(m_variableFields[v], s.variables[v]);
+  put(m_dateField, s.date);
+}
+
+void TAExplorer::unpack(const Word* in, State& s) const
+{
+  auto get = [&](const Field& f) {
+    const Word mask = f.width == 64 ? ~Word{} : (Word{1} << f.width) - 1;
+    return int32_t(int64_t((in[f.word] >> f.shift) & mask) + f.bias);
+  };
+
+  s.locations.resize(m_locationFields.size());
+  s.clocks.resize(m_clockFields.size());
+  for (std::size_t p = 0; p < s.locations.size(); p++)
+  {
+    s.locations[p] = uint8_t(get(m_locationFields[p]));
+    s.clocks[p] = get(m_clockFields[p]);
+  }
+
+  s.variables.resize(m_variableFields.size());
+  for (std::size_t v = 0; v < s.variables.size(); v++)
+    s.variables[v] = get(m_variableFields[v]);
+  s.date = get(m_dateField);
+}
+
+std::size_t TAExplorer::hash(const Word* s) const noexcept
+{
+  uint64_t h = 0x9E3779B97F4A7C15ull;
+  for (std::size_t i = 0; i < m_words; i++)
+  {
+    h = (h ^ s[i]) * 0xFF51AFD7ED558CCDull;
+    h ^= h >> 32;
+  }
+  return h;
+}
+
+TAExplorer::Ref TAExplorer::insert(const Word* s, const Origin& origin)
+{
+  const std::size_t h = hash(s);
+  const std::size_t index = h >> (64 - shardBits);
+  Shard& shard = m_shards[index];
+
+  std::lock_guard lock{shard.mutex};
+  if (2 * (shard.origins.size() + 1) > shard.table.size())
+    grow(shard);
+
+  const std::size_t mask = shard.table.size() - 1;
+  for (std::size_t slot = h & mask;; slot = (slot + 1) & mask)
+  {
+    const uint32_t entry = shard.table[slot];
+    if (entry == 0)
+    {
+      shard.table[slot] = uint32_t(shard.origins.size() + 1);
+      shard.states.insert(shard.states.end(), s, s + m_words);
+      shard.origins.push_back(origin);
+      m_states.fetch_add(1, std::memory_order_relaxed);
+      return Ref(index) << 32 | Ref(shard.origins.size() - 1);
+    }
+    if (std::equal(s, s + m_words, &shard.states[(entry - 1) * m_words]))
+      return npos;
+  }
+}
+
+void TAExplorer::grow(Shard& shard) const
+{
+  std::vector<uint32_t> table(
+      std::max<std::size_t>(shard.table.size() * 2, 256), 0);
+  const std::size_t mask = table.size() - 1;
+  for (std::size_t i = 0; i < shard.origins.size(); i++)
+  {
+    std::size_t slot = hash(&shard.states[i * m_words]) & mask;
+    while (table[slot] != 0)
+      slot = (slot + 1) & mask;
+    table[slot] = uint32_t(i + 1);
+  }
+  shard.table = std::move(table);
+}
+
+bool TAExplorer::invariants(const State& s) const noexcept
+{
+  const auto& procs = m_network.processes();
+  for (std::size_t p = 0; p < procs.size(); p++)
+  {
+    const auto& loc = m_network.definition(procs[p]).locations[s.locations[p]];
+    if (loc.clock && loc.invariant >= 0
+        && s.clocks[p] > m_bounds[p][loc.invariant])
+      return false;
+  }
+  return true;
+}
+
+// Lets one tick elapse. Returns false if time cannot elapse, or if it does
+// not change the state anymore.
+bool TAExplorer::delay(const State& s, State& next) const
+{
+  if (m_network.committed(s.locations.data())
+      || m_network.urgent(s.locations.data()))
+    return false;
+
+  const auto& procs = m_network.processes();
+  next = s;
+  bool changed = false;
+  for (std::size_t p = 0; p < procs.size(); p++)
+  {
+    const auto& loc = m_network.definition(procs[p]).locations[s.locations[p]];
+    if (!loc.clock)
+      continue;
+    if (next.clocks[p] <= m_maxConstants[p])
+    {
+      next.clocks[p]++;
+      changed = true;
+    }
+    if (loc.invariant >= 0 && next.clocks[p] > m_bounds[p][loc.invariant])
+      return false;
+  }
+
+  if (m_dated && next.date <= m_horizon)
+  {
+    next.date++;
+    changed = true;
+  }
+  return changed;
+}
+
+bool TAExplorer::unboundedDelay(const State& s) const noexcept
+{
+  if (m_network.committed(s.locations.data())
+      || m_network.urgent(s.locations.data()))
+    return false;
+
+  const auto& procs = m_network.processes();
+  for (std::size_t p = 0; p < procs.size(); p++)
+  {
+    const auto& loc = m_network.definition(procs[p]).locations[s.locations[p]];
+    if (loc.clock && loc.invariant >= 0)
+      return false;
+  }
+  return true;
+}
+
+// Calls f with each successor of a state, with the sender and its edge,
+// or -1 for a tick.
+template <typename F>
+void TAExplorer::successors(const State& s, const F& f) const
+{
+  const auto& procs = m_network.processes();
+
+  State next;
+  m_network.transitions(
+      s.locations.data(),
+      s.variables.data(),
+      [&](const TANetwork::Participants& t) {
+        const auto [p, e] = t.front();
+        const auto& edge = m_network.definition(procs[p]).edges[e];
+        if (edge.clockGuard >= 0
+            && s.clocks[p] != m_bounds[p][edge.clockGuard])
+          return;
+
+        // The sender updates first, then the receivers.
+        next = s;
+        for (const auto [q, qe] : t)
+        {
+          const auto& qedge = m_network.definition(procs[q]).edges[qe];
+          next.locations[q] = qedge.target;
+          m_network.update(procs[q], qedge.update, next.variables.data());
+        }
+
+        for (const auto [q, qe] : t)
+        {
+          const auto& def = m_network.definition(procs[q]);
+          const auto& qedge = def.edges[qe];
+          const auto& target = def.locations[qedge.target];
+          if (target.condition && next.variables[procs[q].cond] == 0)
+            return;
+
+          // Clocks which are reset, start or stop being used are zero.
+          if (qedge.reset || !def.locations[qedge.source].clock
+              || !target.clock)
+            next.clocks[q] = 0;
+        }
+
+        if (invariants(next))
+          f(next, p, e);
+      });
+
+  if (delay(s, next))
+    f(next, -1, -1);
+}
+
+template <typename Target, typename Expand>
+CheckResult TAExplorer::explore(const Target& target, const Expand& expand)
+{
+  for (auto& shard : m_shards)
+  {
+    shard.states.clear();
+    shard.origins.clear();
+    shard.table.clear();
+  }
+  m_states = 0;
+  m_interrupted = false;
+  m_found = false;
+  m_target = npos;
+
+  CheckResult res;
+  const auto& procs = m_network.processes();
+  const State init{
+      std::vector<uint8_t>(procs.size(), 0),
+      m_network.variables(),
+      std::vector<int32_t>(procs.size(), 0)};
+  if (!invariants(init))
+    return res;
+
+  Batch batch;
+  batch.states.resize(m_words);
+  pack(init, batch.states.data());
+  batch.refs.push_back(insert(batch.states.data(), {npos, -1, -1}));
+
+  TaskGroup tasks{m_pool};
+  run(tasks, batch, target, expand);
+  tasks.wait();
+
+  for (const auto& shard : m_shards)
+    res.states += shard.origins.size();
+  if (m_found)
+  {
+    res.satisfied = true;
+    res.trace = trace(m_target);
+  }
+  return res;
+}
+
+template <typename Target, typename Expand>
+void TAExplorer::run(
+    TaskGroup& tasks,
+    const Batch& batch,
+    const Target& target,
+    const Expand& expand)
+{
+  Batch next;
+  auto flush = [&] {
+    tasks.run([this, &tasks, &target, &expand, b = std::move(next)] {
+      run(tasks, b, target, expand);
+    });
+    next = {};
+  };
+
+  State s;
+  std::vector<Word> packed(m_words);
+  for (std::size_t i = 0; i < batch.refs.size(); i++)
+  {
+    if (m_found.load(std::memory_order_relaxed)
+        || m_interrupted.load(std::memory_order_relaxed))
+      return;
+    if (m_states.load(std::memory_order_relaxed) > m_stateLimit)
+    {
+      m_interrupted = true;
+      return;
+    }
+
+    unpack(&batch.states[i * m_words], s);
+    const bool expanded = expand(s);
+    bool any = false;
+    if (expanded)
+    {
+      successors(s, [&](const State& succ, int32_t p, int32_t e) {
+        any = true;
+        pack(succ, packed.data());
+        const Ref ref = insert(packed.data(), {batch.refs[i], p, e});
+        if (ref == npos)
+          return;
+
+        next.states.insert(next.states.end(), packed.begin(), packed.end());
+        next.refs.push_back(ref);
+        if (next.refs.size() == batchSize)
+          flush();
+      });
+    }
+
+    if (target(s, expanded && !any))
+    {
+      bool expected = false;
+      if (m_found.compare_exchange_strong(expected, true))
+        m_target = batch.refs[i];
+      return;
+    }
+  }
+
+  if (!next.refs.empty())
+    flush();
+}
+
+// Only called once the exploration is over : the shards are not locked.
+TAExplorer::State TAExplorer::state(Ref ref) const
+{
+  const auto& shard = m_shards[ref >> 32];
+  State s;
+  unpack(&shard.states[(ref & 0xFFFFFFFF) * m_words], s);
+  return s;
+}
+
+std::vector<std::string> TAExplorer::trace(Ref ref) const
+{
+  std::vector<std::string> res;
+  int64_t ticks = 0;
+  auto elapse = [&] {
+    if (ticks > 0)
+      res.push_back("delay " + std::to_string(ticks * m_tick) + " ms");
+    ticks = 0;
+  };
+
+  for (;;)
+  {
+    const Origin& o = m_shards[ref >> 32].origins[ref & 0xFFFFFFFF];
+    if (o.parent == npos)
+      break;
+
+    if (o.process < 0)
+    {
+      ticks++;
+    }
+    else
+    {
+      elapse();
+      res.push_back(m_network.describe(o.process, o.edge));
+    }
+    ref = o.parent;
+  }
+  elapse();
+
+  std::reverse(res.begin(), res.end());
+  return res;
+}
+
+CheckResult TAExplorer::controlErrorReachable()
+{
+  const auto& procs = m_network.processes();
+  const uint8_t error
+      = TANetwork::location(TANetwork::Template::Control, "error");
+
+  return explore(
+      [&](const State& s, bool) {
+        for (std::size_t p = 0; p < procs.size(); p++)
+          if (procs[p].kind == TANetwork::Template::Control
+              && s.locations[p] == error)
+            return true;
+        return false;
+      },
+      [](const State&) { return true; });
+}
+
+CheckResult TAExplorer::mainEndAlwaysHappens()
+{
+  const int32_t end = m_network.find("MainEndEvent");
+  if (end < 0)
+    return {};
+
+  const uint8_t finished
+      = TANetwork::location(TANetwork::Template::Event, "finished");
+  auto happened = [&](const State& s) { return s.locations[end] == finished; };
+
+  // As in TAChecker : a run which never reaches the end stops in a
+  // deadlock, or lets time elapse forever.
+  auto res = explore(
+      [&](const State& s, bool deadlocked) {
+        return !happened(s) && (deadlocked || unboundedDelay(s));
+      },
+      [&](const State& s) { return !happened(s); });
+
+  res.satisfied = !res.satisfied;
+  if (!res.satisfied)
+    res.trace.push_back(
+        unboundedDelay(state(m_target)) ? "time elapses forever"
+                                        : "deadlock");
+  return res;
+}
+
+std::optional<DateBounds> TAExplorer::intervalsEnd()
+{
+  using Template = TANetwork::Template;
+  const auto& procs = m_network.processes();
+  const uint8_t rigid = TANetwork::location(Template::Rigid, "finished");
+  const uint8_t flexible = TANetwork::location(Template::Flexible, "finished");
+  auto finished = [&](const State& s) {
+    for (std::size_t p = 0; p < procs.size(); p++)
+    {
+      if ((procs[p].kind == Template::Rigid && s.locations[p] != rigid)
+          || (procs[p].kind == Template::Flexible
+              && s.locations[p] != flexible))
+        return false;
+    }
+    return true;
+  };
+
+  // The finished states are not expanded : their date is the one at which
+  // their run got there.
+  std::mutex mutex;
+  int32_t min = std::numeric_limits<int32_t>::max();
+  int32_t max = -1;
+
+  m_dated = true;
+  layout();
+  const auto res = explore(
+      [&](const State& s, bool deadlocked) {
+        if (finished(s))
+        {
+          std::lock_guard lock{mutex};
+          min = std::min(min, s.date);
+          max = std::max(max, s.date);
+          return false;
+        }
+        return deadlocked || unboundedDelay(s) || s.date > m_horizon;
+      },
+      [&](const State& s) { return !finished(s); });
+  m_dated = false;
+  layout();
+
+  if (res.satisfied || m_interrupted || max < 0)
+    return {};
+  return DateBounds{int64_t(min) * m_tick, int64_t(max) * m_tick};
+}
+}
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <StaticAnalysis/TAChecker.hpp>
+#include <StaticAnalysis/TANetwork.hpp>
+#include <StaticAnalysis/ThreadPool.hpp>
+
+#include <array>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace stal
+{
+namespace TA
+{
+//! Earliest and latest date of something which happens in every run, in
+//! milliseconds.
+struct DateBounds
+{
+  int64_t min{};
+  int64_t max{};
+};
+
+/**
+ * @brief Exhaustive explorer of a TANetwork in discrete time, run on all
+ * the workers of a ThreadPool.
+ *
+ * The clock constraints of the templates are all closed (t <= k, t == k),
+ * so letting the clocks take integer values only reaches the same
+ * locations as in dense time. Time elapses one tick at a time, a tick being
+ * the greatest common divisor of the durations, and a clock stops
+ * increasing once it is past the largest constant it is compared to.
+ *
+ * A state is packed into a few words : the location of each process, the
+ * value of each variable within its range, and the clocks of the processes
+ * in a location which reads them. The passed states are sharded by hash,
+ * each shard with its own lock. The frontier is cut into batches run as
+ * tasks of the pool, whose workers steal them from one another : there is
+ * no global breadth-first order, so traces are not the shortest ones.
+ */
+class TAExplorer
+{
+public:
+  explicit TAExplorer(
+      const TANetwork& network, ThreadPool& pool = ThreadPool::instance());
+
+  //! E<> a Control is in its error location.
+  CheckResult controlErrorReachable();
+
+  //! A<> MainEndEvent.finished
+  CheckResult mainEndAlwaysHappens();
+
+  //! Dates at which every Rigid and Flexible is finished. Empty if some run
+  //! never gets there, or only after the sum of all the durations.
+  std::optional<DateBounds> intervalsEnd();
+
+  //! Explorations stop once they have passed this many states.
+  void setStateLimit(std::size_t limit) noexcept { m_stateLimit = limit; }
+
+  //! The last exploration stopped at the limit : its result means nothing.
+  bool interrupted() const noexcept { return m_interrupted; }
+
+  //! Duration of a tick, in milliseconds.
+  int32_t tick() const noexcept { return m_tick; }
+
+private:
+  using Word = uint64_t;
+  //! Index of the shard in the high half, of the state in the low one.
+  using Ref = uint64_t;
+  static constexpr Ref npos = Ref(-1);
+  static constexpr int shardBits = 6;
+
+  struct State
+  {
+    std::vector<uint8_t> locations;
+    std::vector<int32_t> variables;
+    //! Clock of each process, in ticks.
+    std::vector<int32_t> clocks;
+    //! Ticks since the start, only counted by intervalsEnd.
+    int32_t date{};
+  };
+
+  //! Bits of a packed state holding value - bias.
+  struct Field
+  {
+    uint32_t word{};
+    uint8_t shift{};
+    uint8_t width{};
+    int32_t bias{};
+  };
+
+  //! Where a state was reached from : process is -1 for a tick.
+  struct Origin
+  {
+    Ref parent;
+    int32_t process;
+    int32_t edge;
+  };
+
+  struct Shard
+  {
+    std::mutex mutex;
+    std::vector<Word> states;
+    std::vector<Origin> origins;
+    //! Open addressing, index of the state + 1.
+    std::vector<uint32_t> table;
+  };
+
+  struct Batch
+  {
+    std::vector<Word> states;
+    std::vector<Ref> refs;
+  };
+
+  void layout();
+  Field field(uint32_t& bits, int32_t lo, int32_t hi) const noexcept;
+  void pack(const State& s, Word* out) const noexcept;
+  void unpack(const Word* in, State& s) const;
+
+  std::size_t hash(const Word* s) const noexcept;
+  Ref insert(const Word* s, const Origin& origin);
+  void grow(Shard& shard) const;
+
+  bool invariants(const State& s) const noexcept;
+  bool delay(const State& s, State& next) const;
+  bool unboundedDelay(const State& s) const noexcept;
+  template <typename F>
+  void successors(const State& s, const F& f) const;
+
+  template <typename Target, typename Expand>
+  CheckResult explore(const Target& target, const Expand& expand);
+  template <typename Target, typename Expand>
+  void run(
+      TaskGroup& tasks,
+      const Batch& batch,
+      const Target& target,
+      const Expand& expand);
+  State state(Ref ref) const;
+  std::vector<std::string> trace(Ref ref) const;
+
+  const TANetwork& m_network;
+  ThreadPool& m_pool;
+
+  int32_t m_tick{1};
+  //! Durations and dates of each process, in ticks.
+  std::vector<std::array<int32_t, 2>> m_bounds;
+  //! Largest constant the clock of each process is compared to, in ticks.
+  std::vector<int32_t> m_maxConstants;
+
+  std::vector<Field> m_locationFields;
+  std::vector<Field> m_variableFields;
+  std::vector<Field> m_clockFields;
+  Field m_dateField;
+  //! The date is part of the states, up to m_horizon + 1.
+  bool m_dated{};
+  int32_t m_horizon{};
+  std::size_t m_words{1};
+
+  std::array<Shard, 1 << shardBits> m_shards;
+  std::size_t m_stateLimit{std::numeric_limits<std::size_t>::max()};
+  std::atomic<std::size_t> m_states{};
+  std::atomic<bool> m_interrupted{};
+  std::atomic<bool> m_found{};
+  Ref m_target{npos};
+};
+}
+}
@@ -0,0 +1,595 @@
+#include "TANetwork.hpp"
+
+#include "TAConversion.hpp"
+
+namespace stal
+{
+namespace TA
+{
+namespace
+{
+using Sync = TANetwork::Sync;
+using Guard = TANetwork::Guard;
+using Update = TANetwork::Update;
+using Definition = TANetwork::Definition;
+
+constexpr int8_t none = -1;
+
+// Transcription of the templates of model-uppaal.xml.in. The initial
+// location is always the first one, and unnamed locations are named after
+// what they do.
+const Definition& eventTemplate()
+{
+  static const Definition def{
+      "Event",
+      {{"waiting", false, false, true, 0, false},
+       {"finished", false, false, false, none, false}},
+      {{0, 1, Sync::Send, 0, 0, Guard::None, Update::Message, true}},
+      {"event"}};
+  return def;
+}
+
+const Definition& eventNDTemplate()
+{
+  static const Definition def{
+      "Event_ND",
+      {{"idle", false, false, false, none, false},
+       {"finished", false, false, false, none, false}},
+      {{0, 1, Sync::Send, 0, none, Guard::None, Update::Message, false}},
+      {"event"}};
+  return def;
+}
+
+const Definition& rigidTemplate()
+{
+  enum : uint8_t
+  {
+    idle,
+    wait,
+    end,
+    skipped,
+    killed,
+    finished
+  };
+  enum : uint8_t
+  {
+    event_s,
+    event_e1,
+    skip_p,
+    kill_p,
+    skip,
+    kill,
+    event_e2
+  };
+  static const Definition def{
+      "Rigid",
+      {{"idle", false, false, false, none, false},
+       {"wait", false, false, true, 0, false},
+       {"end", false, true, false, none, false},
+       {"skipped", true, false, false, none, false},
+       {"killed", true, false, false, none, false},
+       {"finished", false, false, false, none, false}},
+      {{end, finished, Sync::Send, event_e2, none, Guard::None, Update::None,
+        false},
+       {skipped, finished, Sync::Send, skip, none, Guard::None, Update::None,
+        true},
+       {idle, skipped, Sync::Receive, skip_p, none, Guard::None,
+        Update::None, false},
+       {killed, finished, Sync::Send, kill, none, Guard::None, Update::None,
+        true},
+       {wait, killed, Sync::Receive, kill_p, none, Guard::None, Update::None,
+        false},
+       {idle, killed, Sync::Receive, kill_p, none, Guard::None, Update::None,
+        false},
+       {wait, end, Sync::Send, event_e1, 0, Guard::None, Update::None, true},
+       {idle, wait, Sync::Receive, event_s, none, Guard::None, Update::None,
+        true}},
+      {"event_s", "event_e1", "skip_p", "kill_p", "skip", "kill",
+       "event_e2"}};
+  return def;
+}
+
+const Definition& flexibleTemplate()
+{
+  enum : uint8_t
+  {
+    idle,
+    wait_min,
+    flexible,
+    semi_flexible,
+    end,
+    killed,
+    skipped,
+    finished
+  };
+  enum : uint8_t
+  {
+    event_s,
+    event_e1,
+    event_i,
+    event_e2,
+    skip_p,
+    kill_p,
+    skip,
+    kill
+  };
+  static const Definition def{
+      "Flexible",
+      {{"idle", false, false, false, none, false},
+       {"wait_min", false, false, true, 0, false},
+       {"flexible", false, false, false, none, false},
+       {"semi_flexible", false, false, true, 1, false},
+       {"end", true, false, false, none, false},
+       {"killed", true, false, false, none, false},
+       {"skipped", true, false, false, none, false},
+       {"finished", false, false, false, none, false}},
+      {{flexible, killed, Sync::Receive, kill_p, none, Guard::None,
+        Update::None, false},
+       {flexible, end, Sync::Receive, event_i, none, Guard::None,
+        Update::None, false},
+       {wait_min, flexible, Sync::Send, event_e1, 0, Guard::Infinite,
+        Update::None, false},
+       {semi_flexible, end, Sync::None, 0, 1, Guard::None, Update::None,
+        false},
+       {killed, finished, Sync::Send, kill, none, Guard::None, Update::None,
+        true},
+       {skipped, finished, Sync::Send, skip, none, Guard::None, Update::None,
+        true},
+       {idle, skipped, Sync::Receive, skip_p, none, Guard::None,
+        Update::None, false},
+       {end, finished, Sync::Send, event_e2, none, Guard::None, Update::None,
+        true},
+       {semi_flexible, end, Sync::Receive, event_i, none, Guard::None,
+        Update::None, false},
+       {semi_flexible, killed, Sync::Receive, kill_p, none, Guard::None,
+        Update::None, false},
+       {wait_min, semi_flexible, Sync::Send, event_e1, 0, Guard::Finite,
+        Update::None, false},
+       {idle, killed, Sync::Receive, kill_p, none, Guard::None, Update::None,
+        false},
+       {wait_min, killed, Sync::Receive, kill_p, none, Guard::None,
+        Update::None, false},
+       {idle, wait_min, Sync::Receive, event_s, none, Guard::None,
+        Update::None, true}},
+      {"event_s", "event_e1", "event_i", "event_e2", "skip_p", "kill_p",
+       "skip", "kill"}};
+  return def;
+}
+
+const Definition& mixTemplate()
+{
+  enum : uint8_t
+  {
+    idle,
+    forward,
+    finished
+  };
+  enum : uint8_t
+  {
+    event_in,
+    event_out,
+    skip_p,
+    kill_p
+  };
+  static const Definition def{
+      "Mix",
+      {{"idle", false, false, false, none, false},
+       {"forward", true, false, false, none, false},
+       {"finished", false, false, false, none, false}},
+      {{idle, finished, Sync::Receive, skip_p, none, Guard::None,
+        Update::None, false},
+       {idle, finished, Sync::Receive, kill_p, none, Guard::None,
+        Update::None, false},
+       {forward, finished, Sync::Send, event_out, none, Guard::None,
+        Update::None, false},
+       {idle, forward, Sync::Receive, event_in, none, Guard::None,
+        Update::None, false}},
+      {"event_in", "event_out", "skip_p", "kill_p"}};
+  return def;
+}
+
+const Definition& controlTemplate()
+{
+  enum : uint8_t
+  {
+    idle,
+    count,
+    error,
+    finished
+  };
+  enum : uint8_t
+  {
+    event_s1,
+    skip_p,
+    skip,
+    event_e,
+    kill_p,
+    event_s2
+  };
+  static const Definition def{
+      "Control",
+      {{"idle", false, false, false, none, false},
+       {"count", true, false, false, none, false},
+       {"error", false, false, false, none, false},
+       {"finished", false, false, false, none, false}},
+      {{idle, error, Sync::Receive, event_s2, none, Guard::None,
+        Update::None, false},
+       {idle, finished, Sync::Receive, kill_p, none, Guard::None,
+        Update::None, false},
+       {count, idle, Sync::None, 0, none, Guard::CounterLess, Update::None,
+        false},
+       {idle, count, Sync::Receive, event_s1, none, Guard::None,
+        Update::Start, false},
+       {count, finished, Sync::Send, skip, none, Guard::CounterSkip,
+        Update::None, false},
+       {count, finished, Sync::Send, event_e, none, Guard::CounterDone,
+        Update::None, false},
+       {idle, count, Sync::Receive, skip_p, none, Guard::None, Update::Skip,
+        false}},
+      {"event_s1", "skip_p", "skip", "event_e", "kill_p", "event_s2"}};
+  return def;
+}
+
+const Definition& pointTemplate()
+{
+  enum : uint8_t
+  {
+    idle,
+    enabled,
+    cond_true,
+    end,
+    timeout,
+    skipped,
+    finished
+  };
+  enum : uint8_t
+  {
+    event,
+    event_s,
+    skip_p,
+    event_e,
+    kill_p,
+    skip,
+    event_t
+  };
+  static const Definition def{
+      "Point",
+      {{"idle", false, false, false, none, false},
+       {"enabled", false, false, false, none, false},
+       {"cond_true", true, false, false, none, true},
+       {"end", false, true, false, none, false},
+       {"timeout", true, false, false, none, false},
+       {"skipped", true, false, false, none, false},
+       {"finished", false, false, false, none, false}},
+      {{end, finished, Sync::Send, event_e, none, Guard::None, Update::None,
+        false},
+       {enabled, finished, Sync::Receive, kill_p, none, Guard::None,
+        Update::None, false},
+       {idle, finished, Sync::Receive, kill_p, none, Guard::None,
+        Update::None, false},
+       {timeout, finished, Sync::Send, skip, none, Guard::NotUrgent,
+        Update::None, false},
+       {timeout, finished, Sync::Send, event_t, none, Guard::Urgent,
+        Update::None, false},
+       {enabled, timeout, Sync::Receive, event_e, none, Guard::Enabled,
+        Update::None, false},
+       {skipped, finished, Sync::Send, skip, none, Guard::None, Update::None,
+        false},
+       {idle, skipped, Sync::Receive, skip_p, none, Guard::None,
+        Update::None, false},
+       {enabled, skipped, Sync::Receive, event_e, none, Guard::Disabled,
+        Update::None, false},
+       {cond_true, end, Sync::Send, event_t, none, Guard::None,
+        Update::Disable, false},
+       {enabled, cond_true, Sync::Receive, event, none, Guard::NoCondition,
+        Update::Condition, false},
+       {idle, enabled, Sync::Receive, event_s, none, Guard::None,
+        Update::Enable, false}},
+      {"event", "event_s", "skip_p", "event_e", "kill_p", "skip",
+       "event_t"}};
+  return def;
+}
+
+int32_t msec(TimeVal t)
+{
+  return int32_t(t.msec());
+}
+
+// condition() of the Point template
+bool condition(int32_t id, int32_t value, int32_t msg)
+{
+  switch (id)
+  {
+    case 0:
+      return true;
+    case 1:
+      return msg == value;
+    case 2:
+      return msg < value;
+    case 3:
+      return msg <= value;
+    case 4:
+      return msg > value;
+    case 5:
+      return msg >= value;
+    default:
+      return false;
+  }
+}
+}
+
+const TANetwork::Definition& TANetwork::definition(Template t)
+{
+  switch (t)
+  {
+    case Template::Event:
+      return eventTemplate();
+    case Template::Event_ND:
+      return eventNDTemplate();
+    case Template::Rigid:
+      return rigidTemplate();
+    case Template::Flexible:
+      return flexibleTemplate();
+    case Template::Point:
+      return pointTemplate();
+    case Template::Mix:
+      return mixTemplate();
+    case Template::Control:
+    default:
+      return controlTemplate();
+  }
+}
+
+uint8_t TANetwork::location(Template t, std::string_view name) noexcept
+{
+  const auto& locations = definition(t).locations;
+  for (std::size_t i = 0; i < locations.size(); i++)
+    if (name == locations[i].name)
+      return uint8_t(i);
+  return uint8_t(-1);
+}
+
+TANetwork::TANetwork(const ScenarioContent& content)
+{
+  add(content);
+
+  m_receivers.resize(m_channels.size());
+  for (std::size_t p = 0; p < m_processes.size(); p++)
+  {
+    const auto& edges = definition(m_processes[p]).edges;
+    for (std::size_t e = 0; e < edges.size(); e++)
+    {
+      if (edges[e].sync != Sync::Receive)
+        continue;
+      const int32_t c = m_processes[p].channels[edges[e].channel];
+      if (c >= 0)
+        m_receivers[c].emplace_back(int32_t(p), int32_t(e));
+    }
+  }
+}
+
+int32_t TANetwork::find(std::string_view name) const noexcept
+{
+  for (std::size_t i = 0; i < m_processes.size(); i++)
+    if (m_names.view(m_processes[i].name) == name)
+      return int32_t(i);
+  return -1;
+}
+
+bool TANetwork::guard(
+    const Process& p,
+    Guard g,
+    const int32_t* vars) const noexcept
+{
+  switch (g)
+  {
+    case Guard::None:
+      return true;
+    case Guard::Finite:
+      return p.finite;
+    case Guard::Infinite:
+      return !p.finite;
+    case Guard::Enabled:
+      return vars[p.en] != 0;
+    case Guard::Disabled:
+      return vars[p.en] == 0;
+    case Guard::NoCondition:
+      return vars[p.cond] == 0;
+    case Guard::CounterLess:
+      return vars[p.counter] < p.n;
+    case Guard::CounterSkip:
+      return vars[p.counter] == p.n && vars[p.skip_v] != 0;
+    case Guard::CounterDone:
+      return vars[p.counter] == p.n && vars[p.skip_v] == 0;
+    case Guard::Urgent:
+      return p.urg;
+    case Guard::NotUrgent:
+      return !p.urg;
+  }
+  return false;
+}
+
+void TANetwork::update(const Process& p, Update u, int32_t* vars) const
+    noexcept
+{
+  switch (u)
+  {
+    case Update::None:
+      break;
+    case Update::Message:
+      vars[p.msg] = p.val;
+      break;
+    case Update::Enable:
+      vars[p.en] = 1;
+      break;
+    case Update::Disable:
+      vars[p.en] = 0;
+      break;
+    case Update::Condition:
+      vars[p.cond] = condition(p.id, p.value, vars[p.msg]);
+      break;
+    case Update::Start:
+      vars[p.counter]++;
+      vars[p.skip_v] = 0;
+      break;
+    case Update::Skip:
+      vars[p.counter]++;
+      break;
+  }
+}
+
+bool TANetwork::committed(const uint8_t* locations) const noexcept
+{
+  for (std::size_t p = 0; p < m_processes.size(); p++)
+    if (definition(m_processes[p]).locations[locations[p]].committed)
+      return true;
+  return false;
+}
+
+bool TANetwork::urgent(const uint8_t* locations) const noexcept
+{
+  for (std::size_t p = 0; p < m_processes.size(); p++)
+    if (definition(m_processes[p]).locations[locations[p]].urgent)
+      return true;
+  return false;
+}
+
+std::string TANetwork::describe(int32_t process, int32_t edge) const
+{
+  const auto& proc = m_processes[process];
+  const auto& def = definition(proc);
+  const auto& e = def.edges[edge];
+
+  std::string step{name(proc)};
+  step += ": ";
+  step += def.locations[e.source].name;
+  step += " -> ";
+  step += def.locations[e.target].name;
+  if (e.sync == Sync::Send && proc.channels[e.channel] >= 0)
+  {
+    step += " (";
+    step += channel(proc.channels[e.channel]);
+    step += "!)";
+  }
+  return step;
+}
+
+int32_t TANetwork::channel(const ScenarioContent& content, Symbol s)
+{
+  if (s == NoSymbol)
+    return -1;
+  return m_channels.intern(content.symbols.view(s));
+}
+
+int32_t TANetwork::shared(const ScenarioContent& content, Symbol s)
+{
+  if (s == NoSymbol)
+    return local(0);
+
+  const Symbol var = m_shared.intern(content.symbols.view(s));
+  if (std::size_t(var) == m_sharedIndex.size())
+    m_sharedIndex.push_back(local(0));
+  return m_sharedIndex[var];
+}
+
+int32_t TANetwork::local(int32_t init)
+{
+  m_variables.push_back(init);
+  return int32_t(m_variables.size() - 1);
+}
+
+void TANetwork::add(const ScenarioContent& content)
+{
+  auto process = [&](Template kind, Symbol name) -> Process& {
+    Process& p = m_processes.emplace_back();
+    p.kind = kind;
+    p.name = m_names.intern(content.symbols.view(name));
+    p.channels.fill(-1);
+    if (kind == Template::Event || kind == Template::Rigid
+        || kind == Template::Flexible)
+      p.clock = int32_t(m_clocks++);
+    return p;
+  };
+  auto channels = [&](Process& p, std::initializer_list<Symbol> syms) {
+    std::size_t i = 0;
+    for (Symbol s : syms)
+      p.channels[i++] = channel(content, s);
+  };
+
+  for (const auto& e : content.events)
+  {
+    auto& p = process(Template::Event, e.name);
+    channels(p, {e.event});
+    p.msg = shared(content, e.message);
+    p.bounds[0] = msec(e.date);
+    p.val = e.val;
+  }
+
+  for (const auto& e : content.events_nd)
+  {
+    auto& p = process(Template::Event_ND, e.name);
+    channels(p, {e.event});
+    p.msg = shared(content, e.message);
+    p.bounds[0] = msec(e.date);
+    p.val = e.val;
+  }
+
+  for (const auto& r : content.rigids)
+  {
+    auto& p = process(Template::Rigid, r.name);
+    channels(
+        p,
+        {r.event_s, r.event_e1, r.skip_p, r.kill_p, r.skip, r.kill,
+         r.event_e2});
+    p.bounds[0] = msec(r.dur);
+  }
+
+  for (const auto& f : content.flexibles)
+  {
+    auto& p = process(Template::Flexible, f.name);
+    channels(
+        p,
+        {f.event_s, f.event_min, f.event_i, f.event_max, f.skip_p, f.kill_p,
+         f.skip, f.kill});
+    p.bounds[0] = msec(f.dmin);
+    p.bounds[1] = f.finite ? msec(f.dmax) : 0;
+    p.finite = f.finite;
+  }
+
+  for (const auto& pt : content.points)
+  {
+    auto& p = process(Template::Point, pt.name);
+    channels(
+        p,
+        {pt.event, pt.event_s, pt.skip_p, pt.event_e, pt.kill_p, pt.skip,
+         pt.event_t});
+    p.en = shared(content, pt.en);
+    p.msg = shared(content, pt.conditionMessage);
+    p.cond = local(0);
+    p.id = pt.condition;
+    p.value = pt.conditionValue / uppaal_division_factor;
+    p.urg = pt.urgent;
+  }
+
+  for (const auto& m : content.mixs)
+  {
+    auto& p = process(Template::Mix, m.name);
+    channels(p, {m.event_in, m.event_out, m.skip_p, m.kill_p});
+  }
+
+  for (const auto& c : content.controls)
+  {
+    auto& p = process(Template::Control, c.name);
+    channels(
+        p,
+        {c.event_s1, c.skip_p, c.skip, c.event_e, c.kill_p, c.event_s2});
+    p.n = c.num_prev_rels;
+    p.counter = local(0);
+    p.skip_v = local(1);
+  }
+
+  for (const auto& child : content.children)
+    add(*child.content);
+}
+}
+}
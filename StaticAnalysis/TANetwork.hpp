@@ -0,0 +1,289 @@
+#pragma once
+#include <StaticAnalysis/SymbolTable.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace stal
+{
+namespace TA
+{
+struct ScenarioContent;
+
+/**
+ * @brief The automata of a ScenarioContent, instantiated from the templates
+ * of model-uppaal.xml.in.
+ *
+ * The templates are described once, as tables of locations and edges whose
+ * guards and updates refer to the parameters of a process. Each automaton
+ * becomes a process with its parameters resolved : channels and variables
+ * are numbered across all the sub-scenarios, and durations are in
+ * milliseconds.
+ */
+class TANetwork
+{
+public:
+  enum class Template : uint8_t
+  {
+    Event,
+    Event_ND,
+    Rigid,
+    Flexible,
+    Point,
+    Mix,
+    Control
+  };
+
+  enum class Sync : uint8_t
+  {
+    None,
+    Send,
+    Receive
+  };
+
+  //! Data guards, written as in the templates.
+  enum class Guard : uint8_t
+  {
+    None,
+    Finite,        // finite == true
+    Infinite,      // finite == false
+    Enabled,       // en == true
+    Disabled,      // en == false
+    NoCondition,   // cond == false
+    CounterLess,   // counter < n
+    CounterSkip,   // counter == n && skip_v == true
+    CounterDone,   // counter == n && skip_v == false
+    Urgent,        // urg == true
+    NotUrgent      // urg == false
+  };
+
+  //! Data updates, written as in the templates.
+  enum class Update : uint8_t
+  {
+    None,
+    Message,   // msg = val
+    Enable,    // en = true
+    Disable,   // en = false
+    Condition, // cond = condition()
+    Start,     // counter++, skip_v = false
+    Skip       // counter++
+  };
+
+  struct Location
+  {
+    const char* name;
+    bool committed;
+    bool urgent;
+    //! Clock t is used in this location : invariant t <= bounds[invariant].
+    bool clock;
+    int8_t invariant;
+    //! Invariant cond == true.
+    bool condition;
+  };
+
+  struct Edge
+  {
+    uint8_t source;
+    uint8_t target;
+    Sync sync;
+    //! Index of the channel parameter of the process.
+    uint8_t channel;
+    //! Clock guard t == bounds[clockGuard], if not negative.
+    int8_t clockGuard;
+    Guard guard;
+    Update update;
+    bool reset;
+  };
+
+  struct Definition
+  {
+    const char* name;
+    std::vector<Location> locations;
+    std::vector<Edge> edges;
+    //! Names of the channel parameters, in order.
+    std::vector<const char*> channels;
+  };
+
+  static const Definition& definition(Template t);
+  //! Index of the location of a template with a given name.
+  static uint8_t location(Template t, std::string_view name) noexcept;
+
+  struct Process
+  {
+    Template kind;
+    Symbol name;
+
+    //! Channel parameters, or -1 when unset.
+    std::array<int32_t, 8> channels;
+    //! Durations and dates the clock is compared to, in milliseconds.
+    std::array<int32_t, 2> bounds{};
+    //! Index of the clock, or -1 for templates without one.
+    int32_t clock{-1};
+
+    // Variables : msg and en are shared, the others are local.
+    int32_t msg{-1};
+    int32_t en{-1};
+    int32_t cond{-1};
+    int32_t counter{-1};
+    int32_t skip_v{-1};
+
+    // Constant parameters
+    int32_t val{};
+    int32_t id{};
+    int32_t value{};
+    int32_t n{};
+    bool finite{};
+    bool urg{};
+  };
+
+  explicit TANetwork(const ScenarioContent& content);
+
+  const std::vector<Process>& processes() const noexcept { return m_processes; }
+  const Definition& definition(const Process& p) const noexcept
+  {
+    return definition(p.kind);
+  }
+
+  std::string_view name(const Process& p) const noexcept
+  {
+    return m_names.view(p.name);
+  }
+  std::string_view channel(int32_t c) const noexcept
+  {
+    return m_channels.view(c);
+  }
+
+  std::size_t channelCount() const noexcept { return m_channels.size(); }
+  std::size_t clockCount() const noexcept { return m_clocks; }
+
+  //! Initial values of the variables.
+  const std::vector<int32_t>& variables() const noexcept
+  {
+    return m_variables;
+  }
+
+  //! Index of the process with a given name, or -1.
+  int32_t find(std::string_view name) const noexcept;
+
+  //! Text of a step of a trace, e.g. "C0: wait -> end (event_e!)".
+  std::string describe(int32_t process, int32_t edge) const;
+
+  // Untimed semantics, over the locations of all the processes and the
+  // values of all the variables.
+  bool guard(const Process& p, Guard g, const int32_t* vars) const noexcept;
+  void update(const Process& p, Update u, int32_t* vars) const noexcept;
+  bool committed(const uint8_t* locations) const noexcept;
+  bool urgent(const uint8_t* locations) const noexcept;
+
+  //! The processes taking a transition with their edge, sender first.
+  using Participants = std::vector<std::pair<int32_t, int32_t>>;
+
+  /**
+   * @brief Calls f with each transition the network can take : an internal
+   * edge, or a send with one matching edge of every process able to
+   * receive. Clock guards and invariants are left to the caller.
+   */
+  template <typename F>
+  void transitions(
+      const uint8_t* locations, const int32_t* vars, const F& f) const;
+
+private:
+  void add(const ScenarioContent& content);
+  int32_t channel(const ScenarioContent& content, Symbol s);
+  int32_t shared(const ScenarioContent& content, Symbol s);
+  int32_t local(int32_t init);
+
+  SymbolTable m_names;
+  SymbolTable m_channels;
+  SymbolTable m_shared;
+  std::vector<int32_t> m_sharedIndex;
+
+  std::vector<Process> m_processes;
+  std::vector<int32_t> m_variables;
+  std::size_t m_clocks{};
+
+  //! Receiving edges of each channel, as (process, edge).
+  std::vector<std::vector<std::pair<int32_t, int32_t>>> m_receivers;
+};
+
+template <typename F>
+void TANetwork::transitions(
+    const uint8_t* locations, const int32_t* vars, const F& f) const
+{
+  const bool inCommitted = committed(locations);
+
+  Participants t;
+  std::vector<std::pair<int32_t, int32_t>> receivers;
+  std::vector<std::pair<std::size_t, std::size_t>> groups;
+
+  for (std::size_t p = 0; p < m_processes.size(); p++)
+  {
+    const auto& proc = m_processes[p];
+    const auto& def = definition(proc);
+    const uint8_t loc = locations[p];
+    const bool senderCommitted = def.locations[loc].committed;
+
+    for (std::size_t e = 0; e < def.edges.size(); e++)
+    {
+      const auto& edge = def.edges[e];
+      if (edge.source != loc || edge.sync == Sync::Receive
+          || !guard(proc, edge.guard, vars))
+        continue;
+
+      t.assign(1, {int32_t(p), int32_t(e)});
+      const int32_t c
+          = edge.sync == Sync::Send ? proc.channels[edge.channel] : -1;
+      if (c < 0)
+      {
+        if (!inCommitted || senderCommitted)
+          f(t);
+        continue;
+      }
+
+      // Enabled receiving edges, grouped by process
+      receivers.clear();
+      groups.clear();
+      for (auto [q, qe] : m_receivers[c])
+      {
+        const auto& qedge = definition(m_processes[q]).edges[qe];
+        if (q == int32_t(p) || qedge.source != locations[q]
+            || !guard(m_processes[q], qedge.guard, vars))
+          continue;
+
+        if (groups.empty() || receivers.back().first != q)
+          groups.emplace_back(receivers.size(), receivers.size());
+        receivers.emplace_back(q, qe);
+        groups.back().second++;
+      }
+
+      // Every combination of one edge per receiving process
+      auto choose = [&](auto& self, std::size_t g, bool withCommitted) {
+        if (g == groups.size())
+        {
+          if (!inCommitted || withCommitted)
+            f(t);
+          return;
+        }
+        for (std::size_t i = groups[g].first; i < groups[g].second; i++)
+        {
+          const int32_t q = receivers[i].first;
+          t.push_back(receivers[i]);
+          self(
+              self,
+              g + 1,
+              withCommitted
+                  || definition(m_processes[q]).locations[locations[q]]
+                         .committed);
+          t.pop_back();
+        }
+      };
+      choose(choose, 0, senderCommitted);
+    }
+  }
+}
+}
+}
@@ -0,0 +1,541 @@
+#include "TAReduction.hpp"
+
+#include "TAConversion.hpp"
+
+#include <algorithm>
+
+namespace stal
+{
+namespace TA
+{
+namespace
+{
+// How an automaton uses each of its parameters, from model-uppaal.xml.in.
+enum class Role : uint8_t
+{
+  Send,
+  Receive,
+  Variable
+};
+
+template <typename F>
+void fields(Event& e, const F& f)
+{
+  f(e.event, Role::Send);
+  f(e.message, Role::Variable);
+}
+
+template <typename F>
+void fields(Event_ND& e, const F& f)
+{
+  f(e.event, Role::Send);
+  f(e.message, Role::Variable);
+}
+
+template <typename F>
+void fields(Mix& m, const F& f)
+{
+  f(m.event_in, Role::Receive);
+  f(m.event_out, Role::Send);
+  f(m.skip_p, Role::Receive);
+  f(m.kill_p, Role::Receive);
+}
+
+template <typename F>
+void fields(Control& c, const F& f)
+{
+  f(c.event_s1, Role::Receive);
+  f(c.skip_p, Role::Receive);
+  f(c.skip, Role::Send);
+  f(c.event_e, Role::Send);
+  f(c.kill_p, Role::Receive);
+  f(c.event_s2, Role::Receive);
+}
+
+template <typename F>
+void fields(Point& p, const F& f)
+{
+  f(p.en, Role::Variable);
+  f(p.conditionMessage, Role::Variable);
+  f(p.event, Role::Receive);
+  f(p.event_s, Role::Receive);
+  f(p.skip_p, Role::Receive);
+  f(p.event_e, Role::Receive);
+  f(p.event_e, Role::Send);
+  f(p.kill_p, Role::Receive);
+  f(p.skip, Role::Send);
+  f(p.event_t, Role::Send);
+}
+
+template <typename F>
+void fields(Flexible& c, const F& f)
+{
+  f(c.event_s, Role::Receive);
+  f(c.event_min, Role::Send);
+  f(c.event_i, Role::Receive);
+  f(c.event_max, Role::Send);
+  f(c.skip_p, Role::Receive);
+  f(c.kill_p, Role::Receive);
+  f(c.skip, Role::Send);
+  f(c.kill, Role::Send);
+}
+
+template <typename F>
+void fields(Rigid& c, const F& f)
+{
+  f(c.event_s, Role::Receive);
+  f(c.event_e1, Role::Send);
+  f(c.skip_p, Role::Receive);
+  f(c.kill_p, Role::Receive);
+  f(c.skip, Role::Send);
+  f(c.kill, Role::Send);
+  f(c.event_e2, Role::Send);
+}
+
+// Calls f(field, role) for every parameter of every automaton of a content.
+template <typename F>
+void forEachField(ScenarioContent& c, const F& f)
+{
+  auto all = [&](auto& vec) {
+    for (auto& elt : vec)
+      fields(elt, f);
+  };
+  all(c.events);
+  all(c.events_nd);
+  all(c.rigids);
+  all(c.flexibles);
+  all(c.points);
+  all(c.mixs);
+  all(c.controls);
+}
+
+void flatten(ScenarioContent& c, std::vector<ScenarioContent*>& fragments)
+{
+  fragments.push_back(&c);
+  for (auto& child : c.children)
+    flatten(*child.content, fragments);
+}
+
+// Calls f(vec, index) for every automaton of a content, in a fixed order.
+template <typename F>
+void forEachAutomaton(ScenarioContent& c, const F& f)
+{
+  auto all = [&](auto& vec) {
+    for (std::size_t i = 0; i < vec.size(); i++)
+      f(vec, i);
+  };
+  all(c.events);
+  all(c.events_nd);
+  all(c.rigids);
+  all(c.flexibles);
+  all(c.points);
+  all(c.mixs);
+  all(c.controls);
+}
+
+// The content of the root and of all the sub-scenarios. These have their
+// own symbol tables : channels and variables are compared through a table
+// common to all of them.
+class Fragments
+{
+public:
+  explicit Fragments(ScenarioContent& root) : m_root{root}
+  {
+    flatten(root, m_fragments);
+    m_globals.resize(m_fragments.size());
+  }
+
+protected:
+  Symbol global(std::size_t fragment, Symbol local)
+  {
+    if (local == NoSymbol)
+      return NoSymbol;
+
+    auto& globals = m_globals[fragment];
+    const auto& symbols = m_fragments[fragment]->symbols;
+    while (globals.size() <= std::size_t(local))
+      globals.push_back(m_symbols.intern(symbols.view(Symbol(globals.size()))));
+    return globals[local];
+  }
+
+  //! Symbol of a global string in the table of a fragment.
+  Symbol local(std::size_t fragment, Symbol g)
+  {
+    return m_fragments[fragment]->symbols.intern(m_symbols.view(g));
+  }
+
+  //! Only the variables that remain in use are declared.
+  std::vector<bool> pruneVariables()
+  {
+    std::vector<bool> used(m_symbols.size());
+    for (std::size_t i = 0; i < m_fragments.size(); i++)
+    {
+      forEachField(*m_fragments[i], [&](Symbol sym, Role) {
+        if (sym != NoSymbol)
+          used[global(i, sym)] = true;
+      });
+    }
+
+    for (std::size_t i = 0; i < m_fragments.size(); i++)
+    {
+      auto& fragment = *m_fragments[i];
+      auto unused = [&](Symbol sym) {
+        const auto g = std::size_t(global(i, sym));
+        return g >= used.size() || !used[g];
+      };
+      for (auto* vars :
+           {&fragment.broadcasts, &fragment.ints, &fragment.bools})
+        vars->erase(
+            std::remove_if(vars->begin(), vars->end(), unused), vars->end());
+    }
+    return used;
+  }
+
+  ScenarioContent& m_root;
+  std::vector<ScenarioContent*> m_fragments;
+
+  SymbolTable m_symbols;
+  std::vector<std::vector<Symbol>> m_globals;
+};
+
+class Reduction : Fragments
+{
+public:
+  explicit Reduction(ScenarioContent& root) : Fragments{root}
+  {
+    m_unsent = m_symbols.intern("unsent");
+    m_unheard = m_symbols.intern("unheard");
+    for (std::size_t i = 0; i < m_fragments.size(); i++)
+      forEachField(
+          *m_fragments[i], [&](Symbol local, Role) { global(i, local); });
+
+    m_senders.resize(m_symbols.size());
+    m_receivers.resize(m_symbols.size());
+    for (std::size_t i = 0; i < m_fragments.size(); i++)
+    {
+      forEachField(*m_fragments[i], [&](Symbol local, Role role) {
+        count(global(i, local), role, 1);
+      });
+
+      auto& mixs = m_fragments[i]->mixs;
+      for (std::size_t m = 0; m < mixs.size(); m++)
+      {
+        m_mixs.push_back(
+            {i,
+             m,
+             global(i, mixs[m].event_in),
+             global(i, mixs[m].event_out),
+             global(i, mixs[m].skip_p),
+             global(i, mixs[m].kill_p),
+             true});
+      }
+    }
+  }
+
+  void run()
+  {
+    removeDeadMixs();
+    collapseMixChains();
+    mergeChannels();
+    apply();
+  }
+
+private:
+  struct MixRef
+  {
+    std::size_t fragment;
+    std::size_t index;
+    Symbol in, out, skip_p, kill_p;
+    bool alive;
+  };
+
+  void count(Symbol g, Role role, int n) noexcept
+  {
+    if (g == NoSymbol)
+      return;
+    if (role == Role::Send)
+      m_senders[g] += n;
+    else if (role == Role::Receive)
+      m_receivers[g] += n;
+  }
+
+  void remove(MixRef& mix) noexcept
+  {
+    mix.alive = false;
+    count(mix.in, Role::Receive, -1);
+    count(mix.out, Role::Send, -1);
+    count(mix.skip_p, Role::Receive, -1);
+    count(mix.kill_p, Role::Receive, -1);
+  }
+
+  // A Mix whose input never comes never sends anything, and a Mix that
+  // nobody listens to cannot be observed.
+  void removeDeadMixs()
+  {
+    for (bool changed = true; changed;)
+    {
+      changed = false;
+      for (auto& mix : m_mixs)
+      {
+        if (mix.alive
+            && (m_senders[mix.in] == 0 || m_receivers[mix.out] == 0))
+        {
+          remove(mix);
+          changed = true;
+        }
+      }
+    }
+  }
+
+  // in -> M1 -> b -> M2 -> out becomes in -> M1 -> out : M2 would forward b
+  // in the committed step right after M1 sends it, and both are skipped or
+  // killed together.
+  void collapseMixChains()
+  {
+    std::vector<int32_t> soleSender(m_symbols.size(), -1);
+    for (std::size_t i = 0; i < m_mixs.size(); i++)
+    {
+      const auto& mix = m_mixs[i];
+      if (mix.alive && m_senders[mix.out] == 1)
+        soleSender[mix.out] = int32_t(i);
+    }
+
+    for (std::size_t i = 0; i < m_mixs.size(); i++)
+    {
+      auto& second = m_mixs[i];
+      const Symbol b = second.in;
+      if (!second.alive || m_senders[b] != 1 || m_receivers[b] != 1)
+        continue;
+
+      const int32_t first_index = soleSender[b];
+      if (first_index < 0 || std::size_t(first_index) == i)
+        continue;
+
+      auto& first = m_mixs[first_index];
+      if (!first.alive || first.skip_p != second.skip_p
+          || first.kill_p != second.kill_p)
+        continue;
+
+      const Symbol out = second.out;
+      remove(second);
+      count(first.out, Role::Send, -1);
+      first.out = out;
+      count(first.out, Role::Send, 1);
+      if (m_senders[out] == 1)
+        soleSender[out] = first_index;
+    }
+  }
+
+  // Channels on which nothing is ever sent, or on which nothing is ever
+  // received, never synchronise anything : each group is one channel.
+  void mergeChannels()
+  {
+    m_rename.resize(m_symbols.size());
+    for (Symbol g = 0; g < Symbol(m_symbols.size()); g++)
+      m_rename[g] = g;
+
+    std::vector<Symbol> unsent, unheard;
+    for (Symbol g = 0; g < Symbol(m_symbols.size()); g++)
+    {
+      if (m_senders[g] == 0 && m_receivers[g] > 0)
+        unsent.push_back(g);
+      else if (m_receivers[g] == 0 && m_senders[g] > 0)
+        unheard.push_back(g);
+    }
+
+    if (unsent.size() > 1)
+      for (Symbol g : unsent)
+        m_rename[g] = m_unsent;
+    if (unheard.size() > 1)
+      for (Symbol g : unheard)
+        m_rename[g] = m_unheard;
+  }
+
+  void apply()
+  {
+    for (const auto& mix : m_mixs)
+    {
+      if (mix.alive)
+        m_fragments[mix.fragment]->mixs[mix.index].event_out
+            = local(mix.fragment, mix.out);
+    }
+
+    for (std::size_t i = 0; i < m_fragments.size(); i++)
+    {
+      compactMixs(i);
+      forEachField(*m_fragments[i], [&](Symbol& sym, Role) {
+        const Symbol g = global(i, sym);
+        if (g != NoSymbol && m_rename[g] != g)
+          sym = local(i, m_rename[g]);
+      });
+    }
+
+    const auto used = pruneVariables();
+    for (Symbol merged : {m_unsent, m_unheard})
+      if (used[merged])
+        m_root.broadcasts.push_back(local(0, merged));
+  }
+
+  // Removes the dead Mix of a fragment, keeping its children in place.
+  void compactMixs(std::size_t fragment_index)
+  {
+    auto& fragment = *m_fragments[fragment_index];
+    auto& mixs = fragment.mixs;
+
+    std::vector<bool> alive(mixs.size());
+    for (const auto& mix : m_mixs)
+      if (mix.fragment == fragment_index)
+        alive[mix.index] = mix.alive;
+
+    // kept[i] : number of Mix kept before the i-th one
+    std::vector<std::size_t> kept(mixs.size() + 1);
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < mixs.size(); i++)
+    {
+      kept[i] = n;
+      if (alive[i])
+        mixs[n++] = mixs[i];
+    }
+    kept[mixs.size()] = n;
+    mixs.erase(mixs.begin() + n, mixs.end());
+
+    for (auto& child : fragment.children)
+      child.position.mixs = kept[child.position.mixs];
+  }
+
+  Symbol m_unsent{};
+  Symbol m_unheard{};
+
+  std::vector<int> m_senders;
+  std::vector<int> m_receivers;
+  std::vector<MixRef> m_mixs;
+  std::vector<Symbol> m_rename;
+};
+
+// Keeps the automata which can influence a target : the senders of the
+// channels a kept automaton receives on, and the automata using the same
+// variables. Broadcasts never block their sender, so the other automata
+// cannot change what the target does.
+class Slicing : Fragments
+{
+public:
+  Slicing(ScenarioContent& root, std::string_view target) : Fragments{root}
+  {
+    // Automata are numbered in the order of forEachAutomaton.
+    for (std::size_t i = 0; i < m_fragments.size(); i++)
+    {
+      const auto& symbols = m_fragments[i]->symbols;
+      forEachAutomaton(*m_fragments[i], [&](auto& vec, std::size_t index) {
+        const std::size_t a = m_uses.size();
+        const auto name = symbols.view(vec[index].name);
+        m_found = m_found || name == target;
+        if (name == target || name == "MainEndEvent")
+          m_seeds.push_back(a);
+
+        auto& uses = m_uses.emplace_back();
+        fields(vec[index], [&](Symbol local, Role role) {
+          const Symbol g = global(i, local);
+          if (g == NoSymbol)
+            return;
+          uses.emplace_back(g, role);
+          if (role == Role::Receive)
+            return;
+          if (m_influencers.size() <= std::size_t(g))
+            m_influencers.resize(g + 1);
+          m_influencers[g].push_back(a);
+        });
+      });
+    }
+    m_influencers.resize(m_symbols.size());
+  }
+
+  //! Whether the target was found.
+  bool run()
+  {
+    if (!m_found)
+      return false;
+
+    m_kept.assign(m_uses.size(), false);
+    std::vector<std::size_t> pending = m_seeds;
+    for (std::size_t a : pending)
+      m_kept[a] = true;
+
+    while (!pending.empty())
+    {
+      const std::size_t a = pending.back();
+      pending.pop_back();
+      for (const auto [g, role] : m_uses[a])
+      {
+        if (role == Role::Send)
+          continue;
+        for (std::size_t b : m_influencers[g])
+        {
+          if (!m_kept[b])
+          {
+            m_kept[b] = true;
+            pending.push_back(b);
+          }
+        }
+      }
+    }
+
+    apply();
+    return true;
+  }
+
+private:
+  void apply()
+  {
+    using Position = ScenarioContent::Position;
+    std::size_t a = 0;
+    for (auto* fragment : m_fragments)
+    {
+      auto compact = [&](auto& vec, std::size_t Position::*position) {
+        // kept[i] : number of automata kept before the i-th one
+        std::vector<std::size_t> kept(vec.size() + 1);
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < vec.size(); i++, a++)
+        {
+          kept[i] = n;
+          if (m_kept[a])
+            vec[n++] = vec[i];
+        }
+        kept[vec.size()] = n;
+        vec.erase(vec.begin() + n, vec.end());
+
+        for (auto& child : fragment->children)
+          child.position.*position = kept[child.position.*position];
+      };
+      compact(fragment->events, &Position::events);
+      compact(fragment->events_nd, &Position::events_nd);
+      compact(fragment->rigids, &Position::rigids);
+      compact(fragment->flexibles, &Position::flexibles);
+      compact(fragment->points, &Position::points);
+      compact(fragment->mixs, &Position::mixs);
+      compact(fragment->controls, &Position::controls);
+    }
+
+    pruneVariables();
+  }
+
+  //! Channels and variables of each automaton, with how it uses them.
+  std::vector<std::vector<std::pair<Symbol, Role>>> m_uses;
+  //! Automata sending on each channel or using each variable.
+  std::vector<std::vector<std::size_t>> m_influencers;
+  std::vector<std::size_t> m_seeds;
+  bool m_found{};
+  std::vector<bool> m_kept;
+};
+}
+
+void reduce(ScenarioContent& content)
+{
+  Reduction{content}.run();
+}
+
+bool slice(ScenarioContent& content, std::string_view target)
+{
+  return Slicing{content, target}.run();
+}
+}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string_view>
+
+namespace stal
+{
+namespace TA
+{
+struct ScenarioContent;
+
+/**
+ * @brief Simplifies an automata network without changing its behaviour.
+ *
+ * - Mix automata which can never forward anything are removed : the ones
+ *   whose input is never sent, or whose output nobody receives.
+ * - Chains of Mix are collapsed when the intermediate channel only links
+ *   the two of them and they are skipped and killed by the same channels.
+ * - Channels on which no synchronisation can ever happen, because nothing
+ *   sends or nothing receives on them, are merged.
+ * - Variables which no automaton uses anymore are not declared.
+ */
+void reduce(ScenarioContent& content);
+
+/**
+ * @brief Keeps only the automata which can influence the one named target,
+ * and MainEndEvent.
+ *
+ * Following the channels backwards from the target, an automaton is kept
+ * when it sends on a channel a kept automaton receives on, or shares a
+ * variable with one. The others can only matter through the order of
+ * simultaneous committed steps.
+ *
+ * @return false, and leaves the content as it is, if there is no such
+ * automaton.
+ */
+bool slice(ScenarioContent& content, std::string_view target);
+}
+}
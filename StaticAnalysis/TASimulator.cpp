@@ -0,0 +1,219 @@
+#include "TASimulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace stal
+{
+namespace TA
+{
+namespace
+{
+using Template = TANetwork::Template;
+
+// Runs made by a task of the pool.
+constexpr std::size_t runsPerTask = 64;
+
+// Half-width of the interval for a given number of runs, by
+// Chernoff-Hoeffding : P(|p - estimate| > e) <= 2 exp(-2 n e^2).
+double halfWidth(std::size_t runs, double confidence)
+{
+  return std::sqrt(std::log(2. / (1. - confidence)) / (2. * double(runs)));
+}
+
+Estimate
+estimate(std::size_t successes, std::size_t runs, double confidence)
+{
+  Estimate res;
+  res.successes = successes;
+  res.probability = runs > 0 ? double(successes) / double(runs) : 0.;
+
+  const double e = halfWidth(runs, confidence);
+  res.low = std::max(res.probability - e, 0.);
+  res.high = std::min(res.probability + e, 1.);
+  return res;
+}
+}
+
+TASimulator::TASimulator(const TANetwork& network, ThreadPool& pool)
+    : m_network{network}
+    , m_pool{pool}
+    , m_end{network.find("MainEndEvent")}
+    , m_finished{TANetwork::location(Template::Event, "finished")}
+    , m_error{TANetwork::location(Template::Control, "error")}
+{
+}
+
+TASimulator::Run
+TASimulator::run(std::mt19937_64& rng, int64_t deadline) const
+{
+  const auto& procs = m_network.processes();
+
+  std::vector<uint8_t> locations(procs.size(), 0);
+  std::vector<int32_t> variables = m_network.variables();
+  std::vector<int32_t> next;
+  // Date of the last reset of each clock, and of the trigger of each
+  // Event_ND.
+  std::vector<int64_t> resets(procs.size(), 0);
+  std::vector<int64_t> triggers(procs.size(), 0);
+  for (std::size_t p = 0; p < procs.size(); p++)
+  {
+    if (procs[p].kind == Template::Event_ND && procs[p].bounds[0] > 0)
+    {
+      std::exponential_distribution<double> date{1. / procs[p].bounds[0]};
+      triggers[p] = std::llround(date(rng));
+    }
+  }
+
+  Run res;
+  int64_t now = 0;
+  TANetwork::Participants chosen;
+  for (;;)
+  {
+    // One of the transitions enabled now, by reservoir sampling
+    std::size_t enabled = 0;
+    m_network.transitions(
+        locations.data(),
+        variables.data(),
+        [&](const TANetwork::Participants& t) {
+          const auto [p, e] = t.front();
+          const auto& edge = m_network.definition(procs[p]).edges[e];
+          if (edge.clockGuard >= 0
+              && now - resets[p] != procs[p].bounds[edge.clockGuard])
+            return;
+          if (procs[p].kind == Template::Event_ND && now < triggers[p])
+            return;
+
+          // The cond == true invariant of the Points
+          auto condition = [&](const std::pair<int32_t, int32_t>& pe) {
+            const auto& def = m_network.definition(procs[pe.first]);
+            return def.locations[def.edges[pe.second].target].condition;
+          };
+          if (std::any_of(t.begin(), t.end(), condition))
+          {
+            next = variables;
+            for (const auto [q, qe] : t)
+              m_network.update(
+                  procs[q],
+                  m_network.definition(procs[q]).edges[qe].update,
+                  next.data());
+            for (const auto& pe : t)
+              if (condition(pe) && next[procs[pe.first].cond] == 0)
+                return;
+          }
+
+          if (std::uniform_int_distribution<std::size_t>{0, enabled++}(rng)
+              == 0)
+            chosen = t;
+        });
+
+    if (enabled > 0)
+    {
+      for (const auto [q, qe] : chosen)
+      {
+        const auto& edge = m_network.definition(procs[q]).edges[qe];
+        locations[q] = edge.target;
+        m_network.update(procs[q], edge.update, variables.data());
+        if (edge.reset)
+          resets[q] = now;
+
+        if (procs[q].kind == Template::Control && locations[q] == m_error)
+          res.error = true;
+      }
+
+      if (!res.ended && m_end >= 0 && locations[m_end] == m_finished)
+      {
+        res.ended = true;
+        res.endDate = now;
+      }
+      continue;
+    }
+
+    // Time cannot elapse : the run is stuck.
+    if (m_network.committed(locations.data())
+        || m_network.urgent(locations.data()))
+      break;
+
+    // Next date at which a clock guard holds or an Event_ND triggers
+    int64_t date = std::numeric_limits<int64_t>::max();
+    for (std::size_t p = 0; p < procs.size(); p++)
+    {
+      if (procs[p].kind == Template::Event_ND)
+      {
+        if (locations[p] == 0)
+          date = std::min(date, triggers[p]);
+        continue;
+      }
+
+      for (const auto& edge : m_network.definition(procs[p]).edges)
+      {
+        if (edge.source != locations[p] || edge.clockGuard < 0
+            || edge.sync == TANetwork::Sync::Receive)
+          continue;
+        const int64_t at = resets[p] + procs[p].bounds[edge.clockGuard];
+        if (at > now)
+          date = std::min(date, at);
+      }
+    }
+
+    if (date == std::numeric_limits<int64_t>::max() || date > deadline)
+      break;
+    now = date;
+  }
+
+  return res;
+}
+
+SimulationResult TASimulator::simulate(const SimulationOptions& options) const
+{
+  const double e = options.precision;
+  const auto runs = std::size_t(
+      std::ceil(std::log(2. / (1. - options.confidence)) / (2. * e * e)));
+
+  struct Totals
+  {
+    std::size_t ended{};
+    std::size_t errors{};
+    double endDates{};
+  };
+  std::vector<Totals> totals((runs + runsPerTask - 1) / runsPerTask);
+
+  TaskGroup tasks{m_pool};
+  for (std::size_t t = 0; t < totals.size(); t++)
+  {
+    tasks.run([&, t] {
+      std::seed_seq seeds{
+          uint32_t(options.seed), uint32_t(options.seed >> 32), uint32_t(t)};
+      std::mt19937_64 rng{seeds};
+
+      auto& total = totals[t];
+      const std::size_t end = std::min(runs, (t + 1) * runsPerTask);
+      for (std::size_t i = t * runsPerTask; i < end; i++)
+      {
+        const Run r = run(rng, options.deadline);
+        total.ended += r.ended;
+        total.errors += r.error;
+        if (r.ended)
+          total.endDates += double(r.endDate);
+      }
+    });
+  }
+  tasks.wait();
+
+  Totals sum;
+  for (const auto& t : totals)
+  {
+    sum.ended += t.ended;
+    sum.errors += t.errors;
+    sum.endDates += t.endDates;
+  }
+
+  SimulationResult res;
+  res.runs = runs;
+  res.mainEnd = estimate(sum.ended, runs, options.confidence);
+  res.controlError = estimate(sum.errors, runs, options.confidence);
+  res.meanEndDate = sum.ended > 0 ? sum.endDates / double(sum.ended) : 0.;
+  return res;
+}
+}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <StaticAnalysis/TANetwork.hpp>
+#include <StaticAnalysis/ThreadPool.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+
+namespace stal
+{
+namespace TA
+{
+struct SimulationOptions
+{
+  //! Half-width of the confidence intervals, and their confidence level :
+  //! they give the number of runs.
+  double precision{0.01};
+  double confidence{0.95};
+
+  //! Runs stop at this date, in milliseconds.
+  int64_t deadline{std::numeric_limits<int64_t>::max()};
+  uint64_t seed{};
+};
+
+//! Probability estimated over independent runs, with its confidence interval.
+struct Estimate
+{
+  double probability{};
+  double low{};
+  double high{};
+  std::size_t successes{};
+};
+
+struct SimulationResult
+{
+  std::size_t runs{};
+  //! MainEndEvent.finished before the deadline.
+  Estimate mainEnd;
+  //! A Control is in its error location before the deadline.
+  Estimate controlError;
+  //! Mean date of MainEndEvent in the runs which reach it, in milliseconds.
+  double meanEndDate{};
+};
+
+/**
+ * @brief Statistical model checking of a TANetwork.
+ *
+ * Runs follow the semantics of UPPAAL-SMC : the network takes a transition
+ * as soon as one is enabled, chosen uniformly among those which are, and
+ * otherwise lets time elapse to the next date at which a clock guard holds
+ * or an Event_ND triggers. The trigger date of each Event_ND is drawn at
+ * the start of a run from an exponential distribution whose mean is its
+ * date in the score : it is what makes runs differ, and the durations of
+ * the Flexibles ended by these triggers vary within their bounds.
+ *
+ * The number of runs comes from the Chernoff-Hoeffding bound, as in
+ * UPPAAL. Runs are split into tasks of the pool, each with its own random
+ * stream seeded from its index, so that the results only depend on the
+ * seed and not on the scheduling.
+ */
+class TASimulator
+{
+public:
+  explicit TASimulator(
+      const TANetwork& network, ThreadPool& pool = ThreadPool::instance());
+
+  SimulationResult simulate(const SimulationOptions& options) const;
+
+private:
+  struct Run
+  {
+    bool ended{};
+    bool error{};
+    int64_t endDate{};
+  };
+
+  Run run(std::mt19937_64& rng, int64_t deadline) const;
+
+  const TANetwork& m_network;
+  ThreadPool& m_pool;
+  int32_t m_end{-1};
+  uint8_t m_finished{};
+  uint8_t m_error{};
+};
+}
+}
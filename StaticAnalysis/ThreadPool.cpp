@@ -0,0 +1,161 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace stal
+{
+namespace
+{
+// Index of the worker running on the current thread, if any.
+thread_local const ThreadPool* t_pool{};
+thread_local std::size_t t_worker{};
+}
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+  m_queues.reserve(threads + 1);
+  for (unsigned i = 0; i < threads + 1; i++)
+    m_queues.push_back(std::make_unique<Queue>());
+
+  m_threads.reserve(threads);
+  for (unsigned i = 0; i < threads; i++)
+    m_threads.emplace_back([this, i] { work(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard lock{m_sleepMutex};
+    m_stop = true;
+  }
+  m_wake.notify_all();
+
+  for (auto& t : m_threads)
+    t.join();
+}
+
+ThreadPool& ThreadPool::instance()
+{
+  static ThreadPool pool{std::max(std::thread::hardware_concurrency(), 2u) - 1};
+  return pool;
+}
+
+void ThreadPool::push(Task task)
+{
+  const std::size_t queue
+      = t_pool == this ? t_worker : m_queues.size() - 1;
+  // Counted before it can be popped, so that the count never wraps.
+  m_pending.fetch_add(1);
+  {
+    std::lock_guard lock{m_queues[queue]->mutex};
+    m_queues[queue]->tasks.push_back(std::move(task));
+  }
+
+  // Taking the lock orders the increment with the predicate of the sleepers.
+  {
+    std::lock_guard lock{m_sleepMutex};
+  }
+  m_wake.notify_one();
+}
+
+bool ThreadPool::pop(std::size_t queue, Task& task)
+{
+  auto& q = *m_queues[queue];
+  std::lock_guard lock{q.mutex};
+  if (q.tasks.empty())
+    return false;
+
+  task = std::move(q.tasks.back());
+  q.tasks.pop_back();
+  m_pending.fetch_sub(1);
+  return true;
+}
+
+bool ThreadPool::steal(std::size_t thief, Task& task)
+{
+  const std::size_t n = m_queues.size();
+  for (std::size_t i = 1; i <= n; i++)
+  {
+    auto& q = *m_queues[(thief + i) % n];
+    std::lock_guard lock{q.mutex};
+    if (!q.tasks.empty())
+    {
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+      m_pending.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::runPending()
+{
+  Task task;
+  const std::size_t self = t_pool == this ? t_worker : m_queues.size() - 1;
+  if (pop(self, task) || steal(self, task))
+  {
+    task();
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::work(std::size_t worker)
+{
+  t_pool = this;
+  t_worker = worker;
+
+  Task task;
+  for (;;)
+  {
+    if (pop(worker, task) || steal(worker, task))
+    {
+      task();
+      task = nullptr;
+      continue;
+    }
+
+    std::unique_lock lock{m_sleepMutex};
+    m_wake.wait(lock, [this] { return m_stop || m_pending.load() > 0; });
+    if (m_stop)
+      return;
+  }
+}
+
+TaskGroup::~TaskGroup()
+{
+  // Tasks refer to the group : they must be done before it goes away.
+  help();
+}
+
+void TaskGroup::help()
+{
+  for (;;)
+  {
+    // Taken before looking for tasks : one added after is not missed.
+    std::size_t changes{};
+    {
+      // Returns with the lock taken : the last task is done with the group.
+      std::lock_guard lock{m_doneMutex};
+      if (m_count.load(std::memory_order_acquire) == 0)
+        return;
+      changes = m_changes;
+    }
+
+    if (m_pool.runPending())
+      continue;
+
+    std::unique_lock lock{m_doneMutex};
+    m_done.wait(lock, [&] { return m_changes != changes; });
+  }
+}
+
+void TaskGroup::wait()
+{
+  help();
+  if (m_error)
+    std::rethrow_exception(std::exchange(m_error, nullptr));
+}
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stal
+{
+/**
+ * @brief Work-stealing thread pool used by the analyses.
+ *
+ * Each worker owns a deque : it pushes and pops its own tasks at the back,
+ * and steals from the front of the other deques once its own is empty.
+ * Tasks pushed from outside the pool go to a shared injection queue.
+ */
+class ThreadPool
+{
+public:
+  using Task = std::function<void()>;
+
+  explicit ThreadPool(unsigned threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  //! Pool shared by the whole plugin, one worker per core but the caller's.
+  static ThreadPool& instance();
+
+  void push(Task task);
+
+  //! Runs one pending task in the calling thread, if there is any.
+  bool runPending();
+
+  std::size_t workerCount() const noexcept { return m_threads.size(); }
+
+private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void work(std::size_t worker);
+  bool pop(std::size_t queue, Task& task);
+  bool steal(std::size_t thief, Task& task);
+
+  // One queue per worker, then the injection queue.
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread> m_threads;
+
+  std::atomic<std::size_t> m_pending{0};
+  std::mutex m_sleepMutex;
+  std::condition_variable m_wake;
+  bool m_stop{false};
+};
+
+/**
+ * @brief Set of tasks that can be waited upon.
+ *
+ * Tasks may add more tasks to their own group. The waiting thread runs
+ * pending tasks, so nested groups cannot deadlock, and only sleeps until
+ * a task of the group is added or finishes once there are none left.
+ * The first exception thrown by a task is rethrown by wait().
+ */
+class TaskGroup
+{
+public:
+  explicit TaskGroup(ThreadPool& pool = ThreadPool::instance()) noexcept
+      : m_pool{pool}
+  {
+  }
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  template <typename F>
+  void run(F&& f)
+  {
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_pool.push([this, f = std::forward<F>(f)]() mutable {
+      try
+      {
+        f();
+      }
+      catch (...)
+      {
+        std::lock_guard lock{m_errorMutex};
+        if (!m_error)
+          m_error = std::current_exception();
+      }
+      // Under the lock, so that the group outlives the notification.
+      std::lock_guard lock{m_doneMutex};
+      m_count.fetch_sub(1, std::memory_order_release);
+      m_changes++;
+      m_done.notify_all();
+    });
+
+    // A waiting thread helps with the new task. The task which adds it is
+    // not finished yet : the group is still there.
+    std::lock_guard lock{m_doneMutex};
+    m_changes++;
+    m_done.notify_all();
+  }
+
+  void wait();
+
+private:
+  void help();
+
+  ThreadPool& m_pool;
+  std::atomic<std::size_t> m_count{0};
+  std::mutex m_doneMutex;
+  std::condition_variable m_done;
+  //! Tasks added or finished, under m_doneMutex.
+  std::size_t m_changes{};
+  std::mutex m_errorMutex;
+  std::exception_ptr m_error;
+};
+}
@@ -1,7 +1,12 @@
 #include "score_addon_staticanalysis.hpp"
 
+#include <score/command/CommandGeneratorMap.hpp>
+
 #include <core/application/ApplicationSettings.hpp>
 
+#include <ossia/detail/for_each_type.hpp>
+
+#include <StaticAnalysis/Commands.hpp>
 #include <StaticAnalysis/ScenarioVisitor.hpp>
 
 score_addon_staticanalysis::score_addon_staticanalysis()
@@ -20,5 +25,17 @@ score_addon_staticanalysis::make_guiApplicationPlugin(
   return new stal::ApplicationPlugin{app};
 }
 
+std::pair<const CommandGroupKey, CommandGeneratorMap>
+score_addon_staticanalysis::make_commands()
+{
+  std::pair<const CommandGroupKey, CommandGeneratorMap> cmds{
+      stal::CommandFactoryName(), CommandGeneratorMap{}};
+
+  ossia::for_each_type<stal::LabelBlocks>(
+      score::commands::FactoryInserter{cmds.second});
+
+  return cmds;
+}
+
 #include <score/plugins/PluginInstances.hpp>
 SCORE_EXPORT_PLUGIN(score_addon_staticanalysis)
@@ -1,5 +1,6 @@
 #pragma once
 #include <score/plugins/application/GUIApplicationPlugin.hpp>
+#include <score/plugins/qt_interfaces/CommandFactory_QtInterface.hpp>
 #include <score/plugins/qt_interfaces/GUIApplicationPlugin_QtInterface.hpp>
 #include <score/plugins/qt_interfaces/PluginRequirements_QtInterface.hpp>
 
@@ -7,7 +8,8 @@
 
 class score_addon_staticanalysis final
     : public score::Plugin_QtInterface,
-      public score::ApplicationPlugin_QtInterface
+      public score::ApplicationPlugin_QtInterface,
+      public score::CommandFactory_QtInterface
 {
   SCORE_PLUGIN_METADATA(1, "e1ef22f4-5fa3-4992-9f88-0e1ec5b5bb7f")
 public:
@@ -16,4 +18,7 @@ public:
 
   score::GUIApplicationPlugin*
   make_guiApplicationPlugin(const score::GUIApplicationContext& app) override;
+
+  std::pair<const CommandGroupKey, CommandGeneratorMap>
+  make_commands() override;
 };